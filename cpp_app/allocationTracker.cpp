@@ -0,0 +1,256 @@
+#include "allocationTracker.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+// Constant-initialized and trivially destructible, so touching it from operator new never allocates
+struct threadCounts
+{
+    uint64_t allocations_;
+    uint64_t bytes_;
+    uint64_t frees_;
+};
+thread_local threadCounts localCounts = {0, 0, 0};
+
+void* allocate(std::size_t size)
+{
+    allocationTracker::countAllocation(size);
+    if (size == 0)
+    {
+        size = 1;  // Every allocation must return a distinct pointer
+    }
+    while (true)
+    {
+        if (void* p = std::malloc(size))
+        {
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void* allocateAligned(std::size_t size, std::align_val_t alignment)
+{
+    allocationTracker::countAllocation(size);
+    std::size_t align = static_cast<std::size_t>(alignment);
+    if (size > SIZE_MAX - (align - 1))
+    {
+        throw std::bad_alloc();  // Rounding up would wrap around to a tiny block
+    }
+    size = (size + align - 1) / align * align;  // aligned_alloc wants a multiple of the alignment
+    if (size == 0)
+    {
+        size = align;
+    }
+    while (true)
+    {
+#ifdef _WIN32
+        void* p = _aligned_malloc(size, align);
+#else
+        void* p = std::aligned_alloc(align, size);
+#endif
+        if (p)
+        {
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void release(void* p)
+{
+    if (p)
+    {
+        allocationTracker::countFree();
+        std::free(p);
+    }
+}
+
+void releaseAligned(void* p)
+{
+    if (p)
+    {
+        allocationTracker::countFree();
+#ifdef _WIN32
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+}
+}  // namespace
+
+std::atomic<bool> allocationTracker::enabled_(false);
+
+void allocationTracker::totals::add(const sample& before, const sample& after)
+{
+    if (!before.valid_ || !after.valid_)
+    {
+        return;
+    }
+    commands_.fetch_add(1, std::memory_order_relaxed);
+    allocations_.fetch_add(after.allocations_ - before.allocations_, std::memory_order_relaxed);
+    bytes_.fetch_add(after.bytes_ - before.bytes_, std::memory_order_relaxed);
+    frees_.fetch_add(after.frees_ - before.frees_, std::memory_order_relaxed);
+}
+
+uint64_t allocationTracker::totals::commands() const
+{
+    return commands_.load(std::memory_order_relaxed);
+}
+
+uint64_t allocationTracker::totals::allocations() const
+{
+    return allocations_.load(std::memory_order_relaxed);
+}
+
+uint64_t allocationTracker::totals::bytes() const
+{
+    return bytes_.load(std::memory_order_relaxed);
+}
+
+uint64_t allocationTracker::totals::frees() const
+{
+    return frees_.load(std::memory_order_relaxed);
+}
+
+void allocationTracker::totals::reset()
+{
+    commands_.store(0, std::memory_order_relaxed);
+    allocations_.store(0, std::memory_order_relaxed);
+    bytes_.store(0, std::memory_order_relaxed);
+    frees_.store(0, std::memory_order_relaxed);
+}
+
+void allocationTracker::enable()
+{
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+allocationTracker::sample allocationTracker::read()
+{
+    sample result;
+    if (enabled())
+    {
+        result.allocations_ = localCounts.allocations_;
+        result.bytes_ = localCounts.bytes_;
+        result.frees_ = localCounts.frees_;
+        result.valid_ = true;
+    }
+    return result;
+}
+
+void allocationTracker::countAllocation(uint64_t bytes)
+{
+    if (enabled())
+    {
+        ++localCounts.allocations_;
+        localCounts.bytes_ += bytes;
+    }
+}
+
+void allocationTracker::countFree()
+{
+    if (enabled())
+    {
+        ++localCounts.frees_;
+    }
+}
+
+// Replacements for the global allocation functions; the remaining forms are defined by the library in
+// terms of these
+void* operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return allocate(size);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return allocate(size);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void* p) noexcept
+{
+    release(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    release(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    release(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    release(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    releaseAligned(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+    releaseAligned(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    releaseAligned(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+{
+    releaseAligned(p);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Optional heap accounting. allocationTracker.cpp replaces the global operator new and delete; once enabled,
+// they count allocations, bytes and frees into plain thread-local counters, so a command's churn is the
+// difference of two reads on the thread that ran it. While disabled the hooks cost one relaxed load.
+class allocationTracker
+{
+  public:
+    struct sample
+    {
+        uint64_t allocations_ = 0;
+        uint64_t bytes_ = 0;  // Requested sizes
+        uint64_t frees_ = 0;
+        bool valid_ = false;
+    };
+
+    // Sums of per-command deltas, added to from any thread
+    class totals
+    {
+      public:
+        void add(const sample& before, const sample& after);
+        uint64_t commands() const;
+        uint64_t allocations() const;
+        uint64_t bytes() const;
+        uint64_t frees() const;
+        void reset();
+
+      private:
+        std::atomic<uint64_t> commands_{0};
+        std::atomic<uint64_t> allocations_{0};
+        std::atomic<uint64_t> bytes_{0};
+        std::atomic<uint64_t> frees_{0};
+    };
+
+    static void enable();
+    static bool enabled()
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    // The calling thread's counts since it started, or an invalid sample while disabled
+    static sample read();
+
+    static void countAllocation(uint64_t bytes);
+    static void countFree();
+
+  private:
+    static std::atomic<bool> enabled_;
+};
@@ -0,0 +1,295 @@
+#include "bvh.hpp"
+#include "memoryFootprint.hpp"
+#include "threadPool.hpp"
+#include "traceRecorder.hpp"
+#include <algorithm>
+#include <numeric>
+
+bvh::bvh() = default;
+
+void bvh::build(const std::vector<aabb>& bounds, threadPool* pool)
+{
+    traceSpan span("bvh::build", "index");
+    uint32_t count = static_cast<uint32_t>(bounds.size());
+    nodes_.clear();
+    order_.resize(count);
+    std::iota(order_.begin(), order_.end(), 0u);
+    positions_.assign(count, 0);
+    leafOf_.assign(count, 0);
+    if (count == 0)
+    {
+        return;
+    }
+
+    buildContext context{bounds, std::vector<vec3>(count), {1}, pool};
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        context.centroids_[i] = bounds[i].empty() ? vec3() : bounds[i].center();
+    }
+
+    // A binary tree with single-primitive leaves at worst has 2n - 1 nodes
+    nodes_.resize(2 * static_cast<size_t>(count) - 1);
+    nodes_[0].parent_ = kNoParent;
+    buildNode(context, 0, 0, count, 0);
+    nodes_.resize(context.nodeCount_);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        positions_[order_[i]] = i;
+    }
+    for (uint32_t n = 0; n < nodes_.size(); ++n)
+    {
+        for (uint32_t i = 0; i < nodes_[n].count_; ++i)
+        {
+            leafOf_[order_[nodes_[n].first_ + i]] = n;
+        }
+    }
+}
+
+void bvh::refit(const std::vector<aabb>& bounds, const std::vector<uint32_t>& changed)
+{
+    std::vector<uint32_t> leaves;
+    leaves.reserve(changed.size());
+    for (uint32_t primitive : changed)
+    {
+        leaves.push_back(leafOf_[primitive]);
+    }
+    std::sort(leaves.begin(), leaves.end());
+    leaves.erase(std::unique(leaves.begin(), leaves.end()), leaves.end());
+
+    // Walk each changed leaf up to the root; a parent is recomputed from both children
+    for (uint32_t leaf : leaves)
+    {
+        for (uint32_t n = leaf; n != kNoParent; n = nodes_[n].parent_)
+        {
+            refitNode(n, bounds);
+        }
+    }
+}
+
+void bvh::queryOverlap(const aabb& region, const std::vector<aabb>& bounds, std::vector<uint32_t>& outPrimitives) const
+{
+    if (nodes_.empty())
+    {
+        return;
+    }
+
+    uint32_t stack[kMaxDepth * 2];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const node& n = nodes_[stack[--top]];
+        if (!n.bounds_.overlaps(region))
+        {
+            continue;
+        }
+        if (n.count_ > 0)
+        {
+            for (uint32_t i = n.first_; i < n.first_ + n.count_; ++i)
+            {
+                if (bounds[order_[i]].overlaps(region))
+                {
+                    outPrimitives.push_back(order_[i]);
+                }
+            }
+            continue;
+        }
+        stack[top++] = n.first_;
+        stack[top++] = n.first_ + 1;
+    }
+}
+
+const std::vector<bvh::node>& bvh::nodes() const
+{
+    return nodes_;
+}
+
+const std::vector<uint32_t>& bvh::order() const
+{
+    return order_;
+}
+
+uint32_t bvh::position(uint32_t primitive) const
+{
+    return positions_[primitive];
+}
+
+size_t bvh::memoryBytes() const
+{
+    return memoryFootprint::vectorBytes(nodes_) + memoryFootprint::vectorBytes(order_) +
+           memoryFootprint::vectorBytes(positions_) + memoryFootprint::vectorBytes(leafOf_);
+}
+
+void bvh::buildNode(buildContext& context, uint32_t nodeIndex, uint32_t begin, uint32_t end, int depth)
+{
+    node& current = nodes_[nodeIndex];
+    current.bounds_ = aabb();
+    aabb centroidBounds;
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        current.bounds_.grow(context.bounds_[order_[i]]);
+        centroidBounds.grow(context.centroids_[order_[i]]);
+    }
+
+    uint32_t axis = 0;
+    uint32_t middle =
+        end - begin > 1 ? partition(context, begin, end, current.bounds_, centroidBounds, depth, axis) : begin;
+    if (middle == begin || middle == end)
+    {
+        current.first_ = begin;
+        current.count_ = end - begin;
+        current.axis_ = 0;
+        return;
+    }
+
+    uint32_t left = context.nodeCount_.fetch_add(2);
+    current.first_ = left;
+    current.count_ = 0;
+    current.axis_ = axis;
+    nodes_[left].parent_ = nodeIndex;
+    nodes_[left + 1].parent_ = nodeIndex;
+
+    // Children own disjoint ranges of order_ and distinct nodes, so they can be built concurrently
+    if (context.pool_ && end - begin >= kParallelThreshold)
+    {
+        context.pool_->parallelFor(2,
+                                   [&](size_t child)
+                                   {
+                                       if (child == 0)
+                                       {
+                                           buildNode(context, left, begin, middle, depth + 1);
+                                       }
+                                       else
+                                       {
+                                           buildNode(context, left + 1, middle, end, depth + 1);
+                                       }
+                                   });
+    }
+    else
+    {
+        buildNode(context, left, begin, middle, depth + 1);
+        buildNode(context, left + 1, middle, end, depth + 1);
+    }
+}
+
+uint32_t bvh::partition(buildContext& context, uint32_t begin, uint32_t end, const aabb& nodeBounds,
+                        const aabb& centroidBounds, int depth, uint32_t& outAxis)
+{
+    uint32_t count = end - begin;
+    vec3 extent = centroidBounds.max_ - centroidBounds.min_;
+    outAxis = extent.x_ >= extent.y_ && extent.x_ >= extent.z_ ? 0 : (extent.y_ >= extent.z_ ? 1 : 2);
+
+    auto medianSplit = [&]()
+    {
+        uint32_t middle = begin + count / 2;
+        uint32_t axis = outAxis;
+        std::nth_element(order_.begin() + begin, order_.begin() + middle, order_.begin() + end,
+                         [&](uint32_t a, uint32_t b)
+                         { return context.centroids_[a][axis] < context.centroids_[b][axis]; });
+        return middle;
+    };
+
+    // Coincident centroids cannot be binned; deep trees switch to medians to bound the traversal stack
+    if (extent[outAxis] <= 0.0f || depth >= kMaxSahDepth)
+    {
+        return count <= kMaxLeafSize ? begin : medianSplit();
+    }
+
+    struct bin
+    {
+        aabb bounds_;
+        uint32_t count_ = 0;
+    };
+
+    float bestCost = 1e30f;
+    uint32_t bestAxis = outAxis;
+    uint32_t bestSplit = 0;
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        if (extent[axis] <= 0.0f)
+        {
+            continue;
+        }
+
+        bin bins[kBinCount];
+        float scale = kBinCount / extent[axis];
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            uint32_t primitive = order_[i];
+            float offset = context.centroids_[primitive][axis] - centroidBounds.min_[axis];
+            uint32_t b = std::min(kBinCount - 1, static_cast<uint32_t>(offset * scale));
+            bins[b].bounds_.grow(context.bounds_[primitive]);
+            ++bins[b].count_;
+        }
+
+        // Sweep from the right to get the suffix areas, then from the left to cost each plane
+        float rightArea[kBinCount];
+        uint32_t rightCount[kBinCount];
+        aabb accumulated;
+        uint32_t accumulatedCount = 0;
+        for (uint32_t b = kBinCount - 1; b > 0; --b)
+        {
+            accumulated.grow(bins[b].bounds_);
+            accumulatedCount += bins[b].count_;
+            rightArea[b] = accumulated.surfaceArea();
+            rightCount[b] = accumulatedCount;
+        }
+        accumulated = aabb();
+        accumulatedCount = 0;
+        for (uint32_t b = 0; b < kBinCount - 1; ++b)
+        {
+            accumulated.grow(bins[b].bounds_);
+            accumulatedCount += bins[b].count_;
+            if (accumulatedCount == 0 || rightCount[b + 1] == 0)
+            {
+                continue;
+            }
+            float cost = accumulated.surfaceArea() * accumulatedCount + rightArea[b + 1] * rightCount[b + 1];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b;
+            }
+        }
+    }
+
+    if (bestCost >= 1e30f)
+    {
+        return count <= kMaxLeafSize ? begin : medianSplit();
+    }
+
+    // Keep small nodes as leaves when splitting would not reduce the expected intersection cost
+    if (count <= kMaxLeafSize && bestCost >= nodeBounds.surfaceArea() * count)
+    {
+        return begin;
+    }
+
+    outAxis = bestAxis;
+    float scale = kBinCount / extent[bestAxis];
+    auto split = std::partition(order_.begin() + begin, order_.begin() + end,
+                                [&](uint32_t primitive)
+                                {
+                                    float offset =
+                                        context.centroids_[primitive][bestAxis] - centroidBounds.min_[bestAxis];
+                                    return std::min(kBinCount - 1, static_cast<uint32_t>(offset * scale)) <= bestSplit;
+                                });
+    return static_cast<uint32_t>(split - order_.begin());
+}
+
+void bvh::refitNode(uint32_t nodeIndex, const std::vector<aabb>& bounds)
+{
+    node& n = nodes_[nodeIndex];
+    n.bounds_ = aabb();
+    if (n.count_ > 0)
+    {
+        for (uint32_t i = n.first_; i < n.first_ + n.count_; ++i)
+        {
+            n.bounds_.grow(bounds[order_[i]]);
+        }
+        return;
+    }
+    n.bounds_.grow(nodes_[n.first_].bounds_);
+    n.bounds_.grow(nodes_[n.first_ + 1].bounds_);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "sceneGeometry.hpp"
+
+class threadPool;
+
+// Bounding volume hierarchy over primitive bounds. Built top-down with binned SAH; subtrees are
+// built in parallel. Leaves reference a contiguous range of order(), so per-leaf data can be
+// stored in leaf order by the owner.
+class bvh
+{
+  public:
+    struct node
+    {
+        aabb bounds_;
+        uint32_t first_;  // Leaf: first position in order(); interior: left child (right is first_ + 1)
+        uint32_t count_;  // Primitives in a leaf, 0 for interior nodes
+        uint32_t parent_;
+        uint32_t axis_;  // Split axis of interior nodes, used to visit the nearer child first
+    };
+
+    static constexpr uint32_t kNoParent = 0xffffffffu;
+    static constexpr int kMaxDepth = 64;  // Bounds the traversal stack: SAH depth plus at most 32 median levels
+
+    bvh();
+
+    void build(const std::vector<aabb>& bounds, threadPool* pool);
+
+    // Updates the bounds of the listed primitives and their ancestors; the topology is kept
+    void refit(const std::vector<aabb>& bounds, const std::vector<uint32_t>& changed);
+
+    // Primitives whose bounds overlap the region
+    void queryOverlap(const aabb& region, const std::vector<aabb>& bounds, std::vector<uint32_t>& outPrimitives) const;
+
+    const std::vector<node>& nodes() const;
+    const std::vector<uint32_t>& order() const;  // Primitive indices in leaf order
+    uint32_t position(uint32_t primitive) const;  // Inverse of order()
+
+    // Heap held by the node and ordering arrays
+    size_t memoryBytes() const;
+
+  private:
+    static constexpr uint32_t kMaxLeafSize = 8;
+    static constexpr uint32_t kBinCount = 16;
+    static constexpr uint32_t kParallelThreshold = 4096;  // Smaller subtrees are built on the current thread
+    static constexpr int kMaxSahDepth = 32;               // Deeper splits fall back to balanced medians
+
+    std::vector<node> nodes_;
+    std::vector<uint32_t> order_;
+    std::vector<uint32_t> positions_;
+    std::vector<uint32_t> leafOf_;
+
+    struct buildContext
+    {
+        const std::vector<aabb>& bounds_;
+        std::vector<vec3> centroids_;
+        std::atomic<uint32_t> nodeCount_;
+        threadPool* pool_;
+    };
+
+    void buildNode(buildContext& context, uint32_t nodeIndex, uint32_t begin, uint32_t end, int depth);
+    uint32_t partition(buildContext& context, uint32_t begin, uint32_t end, const aabb& nodeBounds,
+                       const aabb& centroidBounds, int depth, uint32_t& outAxis);
+    void refitNode(uint32_t nodeIndex, const std::vector<aabb>& bounds);
+};
@@ -1,26 +1,73 @@
 #include "commandHandler.hpp"
+#include "samplingProfiler.hpp"
+#include "sceneRenderer.hpp"
+#include "traceRecorder.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <thread>
 
 commandHandler::commandHandler() = default;
 
+bool commandHandler::enableWriteAheadLog(const std::string &path, writeAheadLog::syncPolicy policy,
+                                         size_t &outReplayed)
+{
+    return core_.enableWriteAheadLog(path, policy, outReplayed);
+}
+
+void commandHandler::configureRenderCache(size_t memoryBytes, const std::string &spillDirectory, size_t spillBytes)
+{
+    core_.configureRenderCache(memoryBytes, spillDirectory, spillBytes);
+}
+
+bool commandHandler::enableSlowLog(const std::string &path, std::chrono::microseconds threshold)
+{
+    return slowLog_.open(path, threshold);
+}
+
 nlohmann::json commandHandler::getSoftwareInfo(const nlohmann::json &params)
 {
+    traceSpan span("commandHandler::getSoftwareInfo", "handler");
     auto info = core_.getSoftwareInfo();
     return softwareInfoToJson(info);
 }
 
 nlohmann::json commandHandler::getSoftwareStatus(const nlohmann::json &params)
 {
+    traceSpan span("commandHandler::getSoftwareStatus", "handler");
     auto status = core_.getSoftwareStatus();
+    runtimeMetrics::processMemory memory = runtimeMetrics::readProcessMemory();
+    double uptime = metrics_.uptimeSeconds();
+
+    // The string fields are the human-readable forms of rss_bytes and uptime_seconds
+    std::ostringstream memoryText;
+    memoryText << std::fixed << std::setprecision(1) << memory.rssBytes_ / (1024.0 * 1024.0) << " MB";
+    uint64_t seconds = static_cast<uint64_t>(uptime);
+    std::string uptimeText = std::to_string(seconds / 3600) + "h " + std::to_string(seconds / 60 % 60) + "m " +
+                             std::to_string(seconds % 60) + "s";
+
     nlohmann::json result = {{"running", status.isRunning_},
                              {"current_project", status.currentProject_},
                              {"object_count", status.totalObjects_},
-                             {"memory_usage", "45.2 MB"},
-                             {"uptime", "2h 15m 30s"}};
+                             {"memory_usage", memoryText.str()},
+                             {"uptime", uptimeText},
+                             {"rss_bytes", memory.rssBytes_},
+                             {"peak_rss_bytes", memory.peakRssBytes_},
+                             {"heap_bytes", memory.heapBytes_},
+                             {"uptime_seconds", uptime},
+                             {"socket_requests", metrics_.total(runtimeMetrics::counter::socketRequests)},
+                             {"grpc_requests", metrics_.total(runtimeMetrics::counter::grpcRequests)},
+                             {"failed_requests", metrics_.total(runtimeMetrics::counter::failedRequests)},
+                             {"connections_accepted", metrics_.total(runtimeMetrics::counter::connectionsAccepted)},
+                             {"active_connections", metrics_.activeConnections()},
+                             {"jobs_queued", jobs_.queuedJobs()},
+                             {"jobs_running", jobs_.runningJobs()}};
     return result;
 }
 
 nlohmann::json commandHandler::createObject(const nlohmann::json &params)
 {
+    traceSpan span("commandHandler::createObject", "handler");
     try
     {
         std::string name = params.value("name", "new_object");
@@ -69,6 +116,7 @@ nlohmann::json commandHandler::createObject(const nlohmann::json &params)
 
 nlohmann::json commandHandler::deleteObject(const nlohmann::json &params)
 {
+    traceSpan span("commandHandler::deleteObject", "handler");
     try
     {
         std::string id = params.value("id", "");
@@ -88,8 +136,43 @@ nlohmann::json commandHandler::deleteObject(const nlohmann::json &params)
     }
 }
 
+nlohmann::json commandHandler::updateObject(const nlohmann::json &params)
+{
+    traceSpan span("commandHandler::updateObject", "handler");
+    try
+    {
+        std::string id = params.value("id", "");
+
+        // Same property keys as create_object
+        std::map<std::string, std::string> properties;
+        for (const char *key : {"size", "radius", "color", "position", "rotation"})
+        {
+            if (params.contains(key))
+            {
+                properties[key] = params[key].is_string() ? params[key].get<std::string>() : params[key].dump();
+            }
+        }
+
+        if (core_.updateObject(id, properties))
+        {
+            softwareCore::softwareObject obj;
+            core_.getObjectInfo(id, obj);
+            return createSuccessResponse({{"object_id", id}, {"object", objectToJson(obj)}});
+        }
+        else
+        {
+            return createErrorResponse("Object not found");
+        }
+    }
+    catch (const std::exception &e)
+    {
+        return createErrorResponse(e.what());
+    }
+}
+
 nlohmann::json commandHandler::listObjects(const nlohmann::json &params)
 {
+    traceSpan span("commandHandler::listObjects", "handler");
     auto objects = core_.listObjects();
     nlohmann::json objects_list = nlohmann::json::array();
 
@@ -104,6 +187,7 @@ nlohmann::json commandHandler::listObjects(const nlohmann::json &params)
 
 nlohmann::json commandHandler::getObjectInfo(const nlohmann::json &params)
 {
+    traceSpan span("commandHandler::getObjectInfo", "handler");
     try
     {
         std::string id = params.value("id", "");
@@ -126,69 +210,239 @@ nlohmann::json commandHandler::getObjectInfo(const nlohmann::json &params)
 
 nlohmann::json commandHandler::executeSoftwareCommand(const nlohmann::json &params)
 {
+    traceSpan span("commandHandler::executeSoftwareCommand", "handler");
     try
     {
         std::string command = params.value("command", "");
-        std::map<std::string, std::string> cmdParams;
+        std::map<std::string, std::string> cmdParams = commandParams(params);
 
-        // Extract any additional parameters
-        if (params.contains("params") && params["params"].is_object())
+        if (params.value("async", false))
         {
-            for (const auto &item : params["params"].items())
-            {
-                if (item.value().is_string())
-                {
-                    cmdParams[item.key()] = item.value().get<std::string>();
-                }
-            }
+            std::string jobId = jobs_.submit("execute_software_command:" + command,
+                                             [this, command, cmdParams](jobManager::jobControl &control)
+                                             { return runSoftwareCommand(command, cmdParams, jobProgress(control)); });
+            return createSuccessResponse(
+                {{"message", "Command started"}, {"command", command}, {"job_id", jobId}});
         }
 
-        if (core_.executeCommand(command, cmdParams))
+        return runSoftwareCommand(command, cmdParams, nullptr);
+    }
+    catch (const std::exception &e)
+    {
+        return createErrorResponse(e.what());
+    }
+}
+
+nlohmann::json commandHandler::runSoftwareCommand(const std::string &command,
+                                                  const std::map<std::string, std::string> &params,
+                                                  const softwareCore::progressCallback &progress)
+{
+    traceSpan span("commandHandler::runSoftwareCommand", "handler");
+    if (command == "render_all_cameras" || (command == "render" && params.count("cameras")))
+    {
+        return runRenderCameras(params, progress);
+    }
+    if (command == "render")
+    {
+        return runRender(params, progress, nullptr);
+    }
+
+    if (core_.executeCommand(command, params))
+    {
+        if (command == "clear_scene")
         {
-            if (command == "render")
-            {
-                return createSuccessResponse(
-                    {{"message", "Render completed successfully"}, {"output_file", "render_output.png"}});
-            }
-            else if (command == "clear_scene")
-            {
-                return createSuccessResponse({{"message", "Scene cleared successfully"}});
-            }
-            else if (command == "reset_camera")
-            {
-                return createSuccessResponse({{"message", "Camera reset successfully"}});
-            }
-            else
-            {
-                return createSuccessResponse({{"message", "Command executed successfully"}});
-            }
+            return createSuccessResponse({{"message", "Scene cleared successfully"}});
+        }
+        else if (command == "reset_camera")
+        {
+            return createSuccessResponse({{"message", "Camera reset successfully"}});
         }
         else
         {
-            return createErrorResponse("Unknown command: " + command);
+            return createSuccessResponse({{"message", "Command executed successfully"}});
         }
     }
+    else
+    {
+        return createErrorResponse("Unknown command: " + command);
+    }
+}
+
+nlohmann::json commandHandler::renderStream(const nlohmann::json &params,
+                                            const std::function<bool(const renderTileUpdate &)> &tileSink)
+{
+    traceSpan span("commandHandler::renderStream", "handler");
+    try
+    {
+        return runRender(commandParams(params), nullptr, tileSink);
+    }
     catch (const std::exception &e)
     {
         return createErrorResponse(e.what());
     }
 }
 
+nlohmann::json commandHandler::runRender(const std::map<std::string, std::string> &params,
+                                         const softwareCore::progressCallback &progress,
+                                         const std::function<bool(const renderTileUpdate &)> &tileSink)
+{
+    renderSettings settings;
+    renderResult result;
+    std::string error;
+    if (!sceneRenderer::parseSettings(params, settings, error))
+    {
+        return createErrorResponse(error);
+    }
+    settings.tileSink_ = tileSink;
+    if (!core_.render(settings, result, error, progress))
+    {
+        return createErrorResponse(error);
+    }
+    if (!result.sharedMemoryName_.empty())
+    {
+        return createSuccessResponse({{"message", "Render published to shared memory"},
+                                      {"shm_name", result.sharedMemoryName_},
+                                      {"frame", result.frame_}});
+    }
+    return createSuccessResponse({{"message", "Render completed successfully"},
+                                  {"output_file", result.outputFile_},
+                                  {"camera_id", result.cameraId_},
+                                  {"width", result.width_},
+                                  {"height", result.height_},
+                                  {"samples", result.samplesPerPixel_},
+                                  {"tiles", result.tiles_},
+                                  {"tiles_traced", result.tilesTraced_},
+                                  {"render_ms", result.renderMilliseconds_},
+                                  {"simd", result.simdLevel_},
+                                  {"format", imageEncoder::formatName(settings.format_)},
+                                  {"cache_hit", result.cacheHit_}});
+}
+
+nlohmann::json commandHandler::runRenderCameras(const std::map<std::string, std::string> &params,
+                                                const softwareCore::progressCallback &progress)
+{
+    renderSettings settings;
+    std::string error;
+    if (!sceneRenderer::parseSettings(params, settings, error))
+    {
+        return createErrorResponse(error);
+    }
+
+    // Comma-separated camera IDs; absent or "all" renders every camera in the scene
+    std::vector<std::string> cameraIds;
+    auto cameras = params.find("cameras");
+    if (cameras != params.end() && cameras->second != "all")
+    {
+        std::stringstream list(cameras->second);
+        std::string id;
+        while (std::getline(list, id, ','))
+        {
+            if (!id.empty())
+            {
+                cameraIds.push_back(id);
+            }
+        }
+    }
+
+    std::vector<renderResult> results;
+    if (!core_.renderCameras(settings, cameraIds, results, error, progress))
+    {
+        return createErrorResponse(error);
+    }
+
+    nlohmann::json renders = nlohmann::json::array();
+    for (const renderResult &result : results)
+    {
+        nlohmann::json render = {{"camera_id", result.cameraId_},
+                                 {"tiles_traced", result.tilesTraced_},
+                                 {"render_ms", result.renderMilliseconds_},
+                                 {"cache_hit", result.cacheHit_}};
+        if (result.sharedMemoryName_.empty())
+        {
+            render["output_file"] = result.outputFile_;
+        }
+        else
+        {
+            render["shm_name"] = result.sharedMemoryName_;
+            render["frame"] = result.frame_;
+        }
+        renders.push_back(render);
+    }
+    return createSuccessResponse({{"message", "Rendered " + std::to_string(results.size()) + " cameras"},
+                                  {"width", settings.width_},
+                                  {"height", settings.height_},
+                                  {"samples", settings.samplesPerPixel_},
+                                  {"format", imageEncoder::formatName(settings.format_)},
+                                  {"renders", renders}});
+}
+
 nlohmann::json commandHandler::saveProject(const nlohmann::json &params)
 {
+    traceSpan span("commandHandler::saveProject", "handler");
     try
     {
         auto info = core_.getSoftwareInfo();
         std::string filename = params.value("filename", info.currentProject_ + ".json");
+        std::string mode = params.value("mode", "full");
 
-        if (core_.saveProject(filename))
+        // "compact" is an explicit full rewrite that folds the delta sidecar back into the file
+        softwareCore::saveOptions options;
+        if (mode == "full" || mode == "compact")
+        {
+            options.mode_ = softwareCore::saveMode::full;
+        }
+        else if (mode == "delta")
         {
-            return createSuccessResponse({{"message", "Project saved successfully"}, {"filename", filename}});
+            options.mode_ = softwareCore::saveMode::delta;
         }
         else
         {
+            return createErrorResponse("Unknown save mode: " + mode);
+        }
+
+        // 0 picks one shard per hardware thread; more shards than that would only add threads, not speed
+        long long threads = params.value("threads", 1LL);
+        if (threads < 0)
+        {
+            return createErrorResponse("threads must not be negative");
+        }
+        size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+        options.threads_ = threads == 0 ? hardwareThreads : std::min(static_cast<size_t>(threads), hardwareThreads);
+
+        options.compress_ = params.value("compress", false);
+
+        auto respond = [filename](bool saved, softwareCore::saveMode writtenMode)
+        {
+            if (saved)
+            {
+                return createSuccessResponse(
+                    {{"message", "Project saved successfully"},
+                     {"filename", filename},
+                     {"mode", writtenMode == softwareCore::saveMode::delta ? "delta" : "full"}});
+            }
             return createErrorResponse("Could not save project to file: " + filename);
+        };
+
+        if (params.value("async", false))
+        {
+            // Snapshot the scene now, so the file holds the scene as of this request however long the job
+            // waits for a worker; only the serialization runs in the background
+            std::shared_ptr<softwareCore::preparedSave> prepared = core_.prepareSave(filename, options);
+            std::string jobId = jobs_.submit("save_project",
+                                             [this, respond, prepared](jobManager::jobControl &control)
+                                             {
+                                                 softwareCore::saveMode writtenMode;
+                                                 bool saved =
+                                                     core_.saveProject(*prepared, jobProgress(control), writtenMode);
+                                                 return respond(saved, writtenMode);
+                                             });
+            return createSuccessResponse(
+                {{"message", "Project save started"}, {"filename", filename}, {"job_id", jobId}});
         }
+
+        softwareCore::saveMode writtenMode;
+        bool saved = core_.saveProject(filename, options, writtenMode);
+        return respond(saved, writtenMode);
     }
     catch (const std::exception &e)
     {
@@ -198,21 +452,378 @@ nlohmann::json commandHandler::saveProject(const nlohmann::json &params)
 
 nlohmann::json commandHandler::loadProject(const nlohmann::json &params)
 {
+    traceSpan span("commandHandler::loadProject", "handler");
     try
     {
         std::string filename = params.value("filename", "");
 
-        if (core_.loadProject(filename))
+        if (params.value("async", false))
+        {
+            std::string jobId = jobs_.submit("load_project",
+                                             [this, filename](jobManager::jobControl &control)
+                                             { return runLoadProject(filename, jobProgress(control)); });
+            return createSuccessResponse(
+                {{"message", "Project load started"}, {"filename", filename}, {"job_id", jobId}});
+        }
+
+        return runLoadProject(filename, nullptr);
+    }
+    catch (const std::exception &e)
+    {
+        return createErrorResponse(e.what());
+    }
+}
+
+nlohmann::json commandHandler::runLoadProject(const std::string &filename,
+                                              const softwareCore::progressCallback &progress)
+{
+    traceSpan span("commandHandler::runLoadProject", "handler");
+    if (core_.loadProject(filename, progress))
+    {
+        auto objects = core_.listObjects();
+        return createSuccessResponse(
+            {{"message", "Project loaded successfully"}, {"filename", filename}, {"objects_loaded", objects.size()}});
+    }
+    else
+    {
+        return createErrorResponse("Could not load project from file: " + filename);
+    }
+}
+
+nlohmann::json commandHandler::getJobStatus(const nlohmann::json &params)
+{
+    traceSpan span("commandHandler::getJobStatus", "handler");
+    try
+    {
+        std::string id = params.value("job_id", "");
+        jobManager::jobInfo job;
+
+        if (jobs_.getJob(id, job))
+        {
+            return createSuccessResponse({{"job_id", job.id_},
+                                          {"kind", job.kind_},
+                                          {"state", jobManager::stateToString(job.state_)},
+                                          {"progress", job.progress_},
+                                          {"result", job.result_}});
+        }
+        else
+        {
+            return createErrorResponse("Job not found");
+        }
+    }
+    catch (const std::exception &e)
+    {
+        return createErrorResponse(e.what());
+    }
+}
+
+nlohmann::json commandHandler::getMetrics(const nlohmann::json &params)
+{
+    traceSpan span("commandHandler::getMetrics", "handler");
+    try
+    {
+        bool reset = params.value("reset", false);
+        nlohmann::json commands = nlohmann::json::array();
+        metrics_.forEachCommand(
+            [&](runtimeMetrics::transport via, const std::string &command, runtimeMetrics::commandStats &stats)
+            {
+                latencyHistogram::summary summary = stats.latency_.summarize();
+                nlohmann::json hardware = hardwareCountersToJson(stats.counters_);
+                nlohmann::json allocations = allocationsToJson(stats.allocations_);
+                if (reset)
+                {
+                    stats.latency_.reset();
+                    stats.counters_.reset();
+                    stats.allocations_.reset();
+                }
+                if (summary.count_ == 0)
+                {
+                    return;
+                }
+                nlohmann::json entry = {{"transport", runtimeMetrics::transportName(via)},
+                                        {"command", command},
+                                        {"count", summary.count_},
+                                        {"mean_us", summary.meanMicros_},
+                                        {"p50_us", summary.p50Micros_},
+                                        {"p90_us", summary.p90Micros_},
+                                        {"p99_us", summary.p99Micros_},
+                                        {"p999_us", summary.p999Micros_},
+                                        {"max_us", summary.maxMicros_}};
+                if (!hardware.is_null())
+                {
+                    entry["hardware"] = hardware;
+                }
+                if (!allocations.is_null())
+                {
+                    entry["allocations"] = allocations;
+                }
+                commands.push_back(entry);
+            });
+        return createSuccessResponse({{"commands", commands},
+                                      {"hardware_counters", perfCounters::enabled()},
+                                      {"allocation_tracking", allocationTracker::enabled()}});
+    }
+    catch (const std::exception &e)
+    {
+        return createErrorResponse(e.what());
+    }
+}
+
+nlohmann::json commandHandler::traceStart(const nlohmann::json &)
+{
+    try
+    {
+        traceRecorder::instance().start();
+        return createSuccessResponse({{"message", "Tracing started"}});
+    }
+    catch (const std::exception &e)
+    {
+        return createErrorResponse(e.what());
+    }
+}
+
+nlohmann::json commandHandler::traceStop(const nlohmann::json &params)
+{
+    try
+    {
+        std::string filename = params.value("output_file", "trace.json");
+        traceRecorder &recorder = traceRecorder::instance();
+        recorder.stop();
+
+        traceRecorder::dumpStats stats;
+        std::string error;
+        if (!recorder.writeFile(filename, stats, error))
+        {
+            return createErrorResponse(error);
+        }
+        return createSuccessResponse({{"message", "Trace written"},
+                                      {"output_file", filename},
+                                      {"events", stats.events_},
+                                      {"threads", stats.threads_},
+                                      {"overwritten_events", stats.overwritten_},
+                                      {"dropped_threads", stats.droppedThreads_}});
+    }
+    catch (const std::exception &e)
+    {
+        return createErrorResponse(e.what());
+    }
+}
+
+nlohmann::json commandHandler::profileStart(const nlohmann::json &params)
+{
+    try
+    {
+        int frequency = params.value("frequency", samplingProfiler::kDefaultFrequency);
+        std::string error;
+        if (!samplingProfiler::instance().start(frequency, error))
+        {
+            return createErrorResponse(error);
+        }
+        return createSuccessResponse({{"message", "Profiling started"}, {"frequency", frequency}});
+    }
+    catch (const std::exception &e)
+    {
+        return createErrorResponse(e.what());
+    }
+}
+
+nlohmann::json commandHandler::profileStop(const nlohmann::json &params)
+{
+    try
+    {
+        std::string filename = params.value("output_file", "profile.folded");
+        samplingProfiler::dumpStats stats;
+        std::string error;
+        if (!samplingProfiler::instance().stop(filename, stats, error))
+        {
+            return createErrorResponse(error);
+        }
+
+        nlohmann::json hottest = nlohmann::json::array();
+        for (const auto &function : stats.hottest_)
+        {
+            hottest.push_back({{"function", function.name_}, {"samples", function.samples_}});
+        }
+        return createSuccessResponse({{"message", "Profile written"},
+                                      {"output_file", filename},
+                                      {"samples", stats.samples_},
+                                      {"dropped_samples", stats.dropped_},
+                                      {"stacks", stats.stacks_},
+                                      {"frequency", stats.frequency_},
+                                      {"duration_seconds", stats.seconds_},
+                                      {"hottest", hottest}});
+    }
+    catch (const std::exception &e)
+    {
+        return createErrorResponse(e.what());
+    }
+}
+
+nlohmann::json commandHandler::memoryReport(const nlohmann::json &params)
+{
+    traceSpan span("commandHandler::memoryReport", "handler");
+    try
+    {
+        int top = params.value("top", 20);
+        size_t topProperties = top > 0 ? static_cast<size_t>(top) : 0;
+
+        if (params.value("async", false))
+        {
+            std::string jobId = jobs_.submit("memory_report",
+                                             [this, topProperties](jobManager::jobControl &control)
+                                             { return runMemoryReport(topProperties, jobProgress(control)); });
+            return createSuccessResponse({{"message", "Memory report started"}, {"job_id", jobId}});
+        }
+
+        return runMemoryReport(topProperties, nullptr);
+    }
+    catch (const std::exception &e)
+    {
+        return createErrorResponse(e.what());
+    }
+}
+
+nlohmann::json commandHandler::runMemoryReport(size_t topProperties, const softwareCore::progressCallback &progress)
+{
+    softwareCore::memoryReport report;
+    if (!core_.measureMemory(report, progress))
+    {
+        return createErrorResponse("Memory report cancelled");
+    }
+    jobManager::footprint jobs = jobs_.measureMemory();
+
+    // Largest first, so a truncated list still shows where the memory goes
+    auto byBytes = [](const nlohmann::json &a, const nlohmann::json &b)
+    { return a["bytes"].get<size_t>() > b["bytes"].get<size_t>(); };
+
+    size_t objectBytes = 0;
+    nlohmann::json types = nlohmann::json::array();
+    for (const auto &pair : report.types_)
+    {
+        objectBytes += pair.second.bytes_;
+        types.push_back({{"type", pair.first},
+                         {"objects", pair.second.objects_},
+                         {"bytes", pair.second.bytes_},
+                         {"property_bytes", pair.second.propertyBytes_},
+                         {"string_bytes", pair.second.stringBytes_}});
+    }
+    std::stable_sort(types.begin(), types.end(), byBytes);
+
+    nlohmann::json properties = nlohmann::json::array();
+    for (const auto &pair : report.properties_)
+    {
+        properties.push_back({{"name", pair.first}, {"objects", pair.second.objects_}, {"bytes", pair.second.bytes_}});
+    }
+    std::stable_sort(properties.begin(), properties.end(), byBytes);
+    if (properties.size() > topProperties)
+    {
+        properties.erase(properties.begin() + static_cast<std::ptrdiff_t>(topProperties), properties.end());
+    }
+
+    const softwareCore::indexFootprint &index = report.index_;
+    size_t indexBytes = index.bvhBytes_ + index.slotBytes_ + index.packedBytes_ + report.changeTrackingBytes_;
+    const renderCache::footprint &cache = report.renderCache_;
+    size_t cacheBytes = cache.memoryBytes_ + cache.overheadBytes_;
+
+    runtimeMetrics::processMemory memory = runtimeMetrics::readProcessMemory();
+    return createSuccessResponse(
+        {{"objects", report.objects_},
+         {"total_bytes", objectBytes + indexBytes + cacheBytes + report.frames_.bytes_ + jobs.bytes_},
+         {"object_bytes", objectBytes},
+         {"types", types},
+         {"properties", properties},
+         {"property_names", report.properties_.size()},
+         {"index",
+          {{"built", report.indexBuilt_},
+           {"slots", index.slots_},
+           {"bytes", indexBytes},
+           {"bvh_bytes", index.bvhBytes_},
+           {"slot_bytes", index.slotBytes_},
+           {"packed_bytes", index.packedBytes_},
+           {"change_tracking_bytes", report.changeTrackingBytes_}}},
+         {"render_cache",
+          {{"bytes", cacheBytes},
+           {"memory_entries", cache.memoryEntries_},
+           {"image_bytes", cache.memoryBytes_},
+           {"overhead_bytes", cache.overheadBytes_},
+           {"disk_entries", cache.diskEntries_},
+           {"disk_bytes", cache.diskBytes_}}},
+         {"render_frames", {{"frames", report.frames_.frames_}, {"bytes", report.frames_.bytes_}}},
+         {"jobs", {{"jobs", jobs.jobs_}, {"bytes", jobs.bytes_}, {"result_bytes", jobs.resultBytes_}}},
+         {"rss_bytes", memory.rssBytes_},
+         {"heap_bytes", memory.heapBytes_}});
+}
+
+nlohmann::json commandHandler::cancelJob(const nlohmann::json &params)
+{
+    traceSpan span("commandHandler::cancelJob", "handler");
+    try
+    {
+        std::string id = params.value("job_id", "");
+
+        if (jobs_.cancelJob(id))
         {
-            auto objects = core_.listObjects();
-            return createSuccessResponse({{"message", "Project loaded successfully"},
-                                          {"filename", filename},
-                                          {"objects_loaded", objects.size()}});
+            // Running jobs stop at their next progress report; poll get_job_status for the outcome
+            return createSuccessResponse({{"message", "Job cancellation requested"}, {"job_id", id}});
         }
         else
         {
-            return createErrorResponse("Could not load project from file: " + filename);
+            return createErrorResponse("Job not found or already finished");
+        }
+    }
+    catch (const std::exception &e)
+    {
+        return createErrorResponse(e.what());
+    }
+}
+
+nlohmann::json commandHandler::queryRegion(const nlohmann::json &params)
+{
+    traceSpan span("commandHandler::queryRegion", "handler");
+    try
+    {
+        aabb region;
+        if (!vec3FromJson(params, "min", region.min_) || !vec3FromJson(params, "max", region.max_))
+        {
+            return createErrorResponse("min and max must be given as \"x,y,z\"");
         }
+
+        std::vector<std::string> ids;
+        core_.queryRegion(region, ids);
+        return createSuccessResponse({{"object_ids", ids}, {"count", ids.size()}});
+    }
+    catch (const std::exception &e)
+    {
+        return createErrorResponse(e.what());
+    }
+}
+
+nlohmann::json commandHandler::raycast(const nlohmann::json &params)
+{
+    traceSpan span("commandHandler::raycast", "handler");
+    try
+    {
+        vec3 origin;
+        vec3 direction;
+        if (!vec3FromJson(params, "origin", origin) || !vec3FromJson(params, "direction", direction) ||
+            direction.length() == 0.0f)
+        {
+            return createErrorResponse("origin and a non-zero direction must be given as \"x,y,z\"");
+        }
+        float maxDistance = params.value("max_distance", 1e30f);
+
+        std::string id;
+        float distance = 0.0f;
+        if (!core_.raycast(origin, direction, maxDistance, id, distance))
+        {
+            return createSuccessResponse({{"hit", false}});
+        }
+
+        vec3 point = origin + direction.normalized() * distance;
+        return createSuccessResponse({{"hit", true},
+                                      {"object_id", id},
+                                      {"distance", distance},
+                                      {"point", {point.x_, point.y_, point.z_}}});
     }
     catch (const std::exception &e)
     {
@@ -231,6 +842,78 @@ nlohmann::json commandHandler::objectToJson(const softwareCore::softwareObject &
     return {{"name", obj.name_}, {"type", obj.type_}, {"properties", properties}};
 }
 
+std::map<std::string, std::string> commandHandler::commandParams(const nlohmann::json &params)
+{
+    // Extract any additional parameters; gRPC forwards them as a JSON string in "kwargs"
+    std::map<std::string, std::string> cmdParams;
+    nlohmann::json extra = params.value("params", nlohmann::json::object());
+    if (params.contains("kwargs") && params["kwargs"].is_string())
+    {
+        extra = nlohmann::json::parse(params["kwargs"].get<std::string>());
+    }
+    if (extra.is_object())
+    {
+        for (const auto &item : extra.items())
+        {
+            cmdParams[item.key()] = item.value().is_string() ? item.value().get<std::string>() : item.value().dump();
+        }
+    }
+    return cmdParams;
+}
+
+bool commandHandler::vec3FromJson(const nlohmann::json &params, const std::string &key, vec3 &outValue)
+{
+    // Accepts the "x,y,z" form used by object properties, or a three-element array
+    if (!params.contains(key))
+    {
+        return false;
+    }
+    const nlohmann::json &value = params[key];
+    if (value.is_array() && value.size() == 3)
+    {
+        outValue = {value[0].get<float>(), value[1].get<float>(), value[2].get<float>()};
+        return true;
+    }
+    return value.is_string() && sceneGeometry::parseVec3(value.get<std::string>(), outValue);
+}
+
+nlohmann::json commandHandler::hardwareCountersToJson(const perfCounters::totals &counters)
+{
+    uint64_t measured = counters.commands();
+    if (measured == 0)
+    {
+        return nullptr;
+    }
+    uint64_t cycles = counters.value(perfCounters::event::cycles);
+    uint64_t instructions = counters.value(perfCounters::event::instructions);
+    uint64_t cacheMisses = counters.value(perfCounters::event::cacheMisses);
+
+    // Low IPC with many misses per thousand instructions means the command waits on memory
+    return {{"measured", measured},
+            {"cycles", cycles},
+            {"instructions", instructions},
+            {"cache_misses", cacheMisses},
+            {"branch_misses", counters.value(perfCounters::event::branchMisses)},
+            {"ipc", cycles > 0 ? static_cast<double>(instructions) / cycles : 0.0},
+            {"cache_misses_per_kilo_instruction",
+             instructions > 0 ? 1000.0 * static_cast<double>(cacheMisses) / instructions : 0.0}};
+}
+
+nlohmann::json commandHandler::allocationsToJson(const allocationTracker::totals &allocations)
+{
+    uint64_t measured = allocations.commands();
+    if (measured == 0)
+    {
+        return nullptr;
+    }
+    return {{"measured", measured},
+            {"allocations", allocations.allocations()},
+            {"bytes", allocations.bytes()},
+            {"frees", allocations.frees()},
+            {"allocations_per_request", static_cast<double>(allocations.allocations()) / measured},
+            {"bytes_per_request", static_cast<double>(allocations.bytes()) / measured}};
+}
+
 nlohmann::json commandHandler::softwareInfoToJson(const softwareCore::softwareInfo &info)
 {
     return {
@@ -241,7 +924,19 @@ nlohmann::json commandHandler::softwareInfoToJson(const softwareCore::softwareIn
         {"total_objects", info.totalObjects_},
         {"available_commands", nlohmann::json::array({"get_software_info", "get_software_status", "create_object",
                                                       "delete_object", "list_objects", "get_object_info",
-                                                      "execute_software_command", "save_project", "load_project"})}};
+                                                      "execute_software_command", "save_project", "load_project",
+                                                      "get_job_status", "cancel_job", "update_object", "query_region",
+                                                      "raycast", "get_metrics", "trace_start", "trace_stop",
+                                                      "profile_start", "profile_stop", "memory_report"})}};
+}
+
+softwareCore::progressCallback commandHandler::jobProgress(jobManager::jobControl &control)
+{
+    return [&control](double progress)
+    {
+        control.setProgress(progress);
+        return !control.cancelled();
+    };
 }
 
 nlohmann::json commandHandler::createSuccessResponse(const nlohmann::json &data)
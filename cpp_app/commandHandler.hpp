@@ -1,34 +1,89 @@
 #pragma once
 
+#include <functional>
 #include <map>
 #include <string>
 #include <vector>
 
+#include "jobManager.hpp"
 #include "nlohmann/json.hpp"
+#include "runtimeMetrics.hpp"
+#include "slowRequestLog.hpp"
 #include "softwareCore.hpp"
 
+struct renderTileUpdate;
+
 // Command handler - responsible for parsing commands and delegating to core
 class commandHandler
 {
   public:
     commandHandler();
 
+    // Startup configuration, called before the server starts accepting requests
+    bool enableWriteAheadLog(const std::string &path, writeAheadLog::syncPolicy policy, size_t &outReplayed);
+    void configureRenderCache(size_t memoryBytes, const std::string &spillDirectory, size_t spillBytes);
+    bool enableSlowLog(const std::string &path, std::chrono::microseconds threshold);
+
+    // Request and connection counters and the slow-request log, recorded by the server strategies
+    runtimeMetrics &metrics()
+    {
+        return metrics_;
+    }
+    slowRequestLog &slowLog()
+    {
+        return slowLog_;
+    }
+
     // Command processing - these methods parse JSON and delegate to core
     nlohmann::json getSoftwareInfo(const nlohmann::json &params);
     nlohmann::json getSoftwareStatus(const nlohmann::json &params);
     nlohmann::json createObject(const nlohmann::json &params);
     nlohmann::json deleteObject(const nlohmann::json &params);
+    nlohmann::json updateObject(const nlohmann::json &params);
     nlohmann::json listObjects(const nlohmann::json &params);
     nlohmann::json getObjectInfo(const nlohmann::json &params);
     nlohmann::json executeSoftwareCommand(const nlohmann::json &params);
     nlohmann::json saveProject(const nlohmann::json &params);
     nlohmann::json loadProject(const nlohmann::json &params);
+    nlohmann::json getJobStatus(const nlohmann::json &params);
+    nlohmann::json cancelJob(const nlohmann::json &params);
+    nlohmann::json queryRegion(const nlohmann::json &params);
+    nlohmann::json raycast(const nlohmann::json &params);
+    nlohmann::json getMetrics(const nlohmann::json &params);
+    nlohmann::json traceStart(const nlohmann::json &params);
+    nlohmann::json traceStop(const nlohmann::json &params);
+    nlohmann::json profileStart(const nlohmann::json &params);
+    nlohmann::json profileStop(const nlohmann::json &params);
+    nlohmann::json memoryReport(const nlohmann::json &params);
+
+    // Render with the execute_software_command params, handing each finished tile to the sink
+    // (from worker threads) before the final response is returned
+    nlohmann::json renderStream(const nlohmann::json &params,
+                                const std::function<bool(const renderTileUpdate &)> &tileSink);
 
   private:
     softwareCore core_;  // The actual business logic
+    jobManager jobs_;    // Background work (async commands); declared after core_ so it stops first
+    runtimeMetrics metrics_;
+    slowRequestLog slowLog_;
+
+    nlohmann::json runSoftwareCommand(const std::string &command, const std::map<std::string, std::string> &params,
+                                      const softwareCore::progressCallback &progress);
+    nlohmann::json runRender(const std::map<std::string, std::string> &params,
+                             const softwareCore::progressCallback &progress,
+                             const std::function<bool(const renderTileUpdate &)> &tileSink);
+    nlohmann::json runRenderCameras(const std::map<std::string, std::string> &params,
+                                    const softwareCore::progressCallback &progress);
+    nlohmann::json runLoadProject(const std::string &filename, const softwareCore::progressCallback &progress);
+    nlohmann::json runMemoryReport(size_t topProperties, const softwareCore::progressCallback &progress);
+    static softwareCore::progressCallback jobProgress(jobManager::jobControl &control);
 
     // Helper methods for JSON conversion
     static nlohmann::json objectToJson(const softwareCore::softwareObject &obj);
+    static std::map<std::string, std::string> commandParams(const nlohmann::json &params);
+    static bool vec3FromJson(const nlohmann::json &params, const std::string &key, vec3 &outValue);
+    static nlohmann::json hardwareCountersToJson(const perfCounters::totals &counters);
+    static nlohmann::json allocationsToJson(const allocationTracker::totals &allocations);
     static nlohmann::json softwareInfoToJson(const softwareCore::softwareInfo &info);
     static nlohmann::json createSuccessResponse(const nlohmann::json &data);
     static nlohmann::json createErrorResponse(const std::string &message);
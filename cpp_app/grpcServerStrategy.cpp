@@ -1,12 +1,30 @@
-#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 
 #include "grpcServerStrategy.hpp"
+#include "logger.hpp"
 #include "nlohmann/json.hpp"
+#include "sceneRenderer.hpp"
+#include "traceRecorder.hpp"
 
 grpcServerStrategy::grpcServerStrategy(const std::string& address) : address_(address)
 {
     // No need to create a separate service - this class IS the service
+
+    // Stats are looked up once here, so dispatch only reads the map
+    for (const char* command : {"get_software_info", "get_software_status", "create_object", "delete_object",
+                                "update_object", "list_objects", "get_object_info", "execute_software_command",
+                                "render_stream", "save_project", "load_project", "get_job_status", "cancel_job",
+                                "query_region", "raycast", "get_metrics", "trace_start", "trace_stop",
+                                "profile_start", "profile_stop", "memory_report"})
+    {
+        commands_[command] = &handler_.metrics().statsFor(runtimeMetrics::transport::grpc, command);
+    }
 }
 
 grpcServerStrategy::~grpcServerStrategy()
@@ -37,7 +55,7 @@ void grpcServerStrategy::start()
             throw std::runtime_error("Failed to start gRPC server");
         }
 
-        std::cout << "Starting gRPC Server on " << address_ << "..." << std::endl;
+        logger::info("grpc", "Starting gRPC server", {{"address", address_}});
 
         // Wait for the server to shutdown (blocking)
         server_->Wait();
@@ -56,7 +74,7 @@ grpc::Status grpcServerStrategy::GetSoftwareInfo(grpc::ServerContext* context,
     try
     {
         nlohmann::json params = nlohmann::json::object();
-        nlohmann::json result = handler_.getSoftwareInfo(params);
+        nlohmann::json result = dispatch("get_software_info", &commandHandler::getSoftwareInfo, params);
 
         auto* info = response->mutable_info();
         jsonToProto(result, info);
@@ -76,7 +94,7 @@ grpc::Status grpcServerStrategy::GetSoftwareStatus(grpc::ServerContext* context,
     try
     {
         nlohmann::json params = nlohmann::json::object();
-        nlohmann::json result = handler_.getSoftwareStatus(params);
+        nlohmann::json result = dispatch("get_software_status", &commandHandler::getSoftwareStatus, params);
 
         auto* status = response->mutable_status();
         jsonToProto(result, status);
@@ -95,7 +113,7 @@ grpc::Status grpcServerStrategy::CreateObject(grpc::ServerContext* context, cons
     try
     {
         nlohmann::json params = protoToJson(*request);
-        nlohmann::json result = handler_.createObject(params);
+        nlohmann::json result = dispatch("create_object", &commandHandler::createObject, params);
 
         jsonToProto(result, response);
 
@@ -113,7 +131,7 @@ grpc::Status grpcServerStrategy::DeleteObject(grpc::ServerContext* context, cons
     try
     {
         nlohmann::json params = protoToJson(*request);
-        nlohmann::json result = handler_.deleteObject(params);
+        nlohmann::json result = dispatch("delete_object", &commandHandler::deleteObject, params);
 
         jsonToProto(result, response);
 
@@ -131,7 +149,7 @@ grpc::Status grpcServerStrategy::ListObjects(grpc::ServerContext* context, const
     try
     {
         nlohmann::json params = nlohmann::json::object();
-        nlohmann::json result = handler_.listObjects(params);
+        nlohmann::json result = dispatch("list_objects", &commandHandler::listObjects, params);
 
         jsonToProto(result, response);
 
@@ -149,7 +167,7 @@ grpc::Status grpcServerStrategy::GetObjectInfo(grpc::ServerContext* context, con
     try
     {
         nlohmann::json params = protoToJson(*request);
-        nlohmann::json result = handler_.getObjectInfo(params);
+        nlohmann::json result = dispatch("get_object_info", &commandHandler::getObjectInfo, params);
 
         jsonToProto(result, response);
 
@@ -168,7 +186,7 @@ grpc::Status grpcServerStrategy::ExecuteSoftwareCommand(grpc::ServerContext* con
     try
     {
         nlohmann::json params = protoToJson(*request);
-        nlohmann::json result = handler_.executeSoftwareCommand(params);
+        nlohmann::json result = dispatch("execute_software_command", &commandHandler::executeSoftwareCommand, params);
 
         jsonToProto(result, response);
 
@@ -180,13 +198,107 @@ grpc::Status grpcServerStrategy::ExecuteSoftwareCommand(grpc::ServerContext* con
     }
 }
 
+grpc::Status grpcServerStrategy::RenderStream(grpc::ServerContext* context, const mcp::RenderStreamRequest* request,
+                                              grpc::ServerWriter<mcp::RenderStreamResponse>* writer)
+{
+    try
+    {
+        traceSpan span("grpc.render_stream", "grpc");
+        handler_.metrics().add(runtimeMetrics::counter::grpcRequests);
+        auto start = std::chrono::steady_clock::now();
+        nlohmann::json params = protoToJson(*request);
+
+        // Tiles finish on the render workers; they are queued and written from this thread so a slow
+        // client never stalls a worker. A client that goes away stops the render at the next tile.
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<mcp::RenderStreamResponse> pending;
+        bool finished = false;
+        std::atomic<bool> clientGone(false);
+        nlohmann::json result;
+        auto sink = [&](const renderTileUpdate& update)
+        {
+            if (clientGone.load() || context->IsCancelled())
+            {
+                return false;
+            }
+            mcp::RenderStreamResponse message;
+            message.set_success(true);
+            message.set_completion_percent(100.0 * update.tilesDone_ / update.tileCount_);
+            auto* tile = message.mutable_tile();
+            tile->set_x(update.x_);
+            tile->set_y(update.y_);
+            tile->set_width(update.width_);
+            tile->set_height(update.height_);
+            tile->set_pixels(update.pixels_.data(), update.pixels_.size());
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending.push_back(std::move(message));
+            }
+            ready.notify_one();
+            return true;
+        };
+        std::thread renderThread(
+            [&]()
+            {
+                result = handler_.renderStream(params, sink);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    finished = true;
+                }
+                ready.notify_one();
+            });
+
+        while (true)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&] { return finished || !pending.empty(); });
+            if (pending.empty())
+            {
+                break;
+            }
+            mcp::RenderStreamResponse message = std::move(pending.front());
+            pending.pop_front();
+            lock.unlock();
+
+            if (!clientGone.load() && !writer->Write(message))
+            {
+                clientGone.store(true);
+            }
+        }
+        renderThread.join();
+
+        requestPhases phases(start);
+        phases.mark(requestPhases::phase::execute);
+        commands_.find("render_stream")->second->latency_.record(phases.totalNanoseconds());
+        handler_.slowLog().record("grpc", "render_stream", phases);
+        if (clientGone.load() || result.contains("error"))
+        {
+            handler_.metrics().add(runtimeMetrics::counter::failedRequests);
+        }
+        if (clientGone.load())
+        {
+            return {grpc::StatusCode::CANCELLED, "Render stream closed by client"};
+        }
+        mcp::RenderStreamResponse last;
+        jsonToProto(result, &last);
+        writer->Write(last);
+
+        return grpc::Status::OK;
+    }
+    catch (const std::exception& e)
+    {
+        return {grpc::StatusCode::INTERNAL, e.what()};
+    }
+}
+
 grpc::Status grpcServerStrategy::SaveProject(grpc::ServerContext* context, const mcp::SaveProjectRequest* request,
                                              mcp::SaveProjectResponse* response)
 {
     try
     {
         nlohmann::json params = protoToJson(*request);
-        nlohmann::json result = handler_.saveProject(params);
+        nlohmann::json result = dispatch("save_project", &commandHandler::saveProject, params);
 
         jsonToProto(result, response);
 
@@ -204,7 +316,97 @@ grpc::Status grpcServerStrategy::LoadProject(grpc::ServerContext* context, const
     try
     {
         nlohmann::json params = protoToJson(*request);
-        nlohmann::json result = handler_.loadProject(params);
+        nlohmann::json result = dispatch("load_project", &commandHandler::loadProject, params);
+
+        jsonToProto(result, response);
+
+        return grpc::Status::OK;
+    }
+    catch (const std::exception& e)
+    {
+        return {grpc::StatusCode::INTERNAL, e.what()};
+    }
+}
+
+grpc::Status grpcServerStrategy::GetJobStatus(grpc::ServerContext* context, const mcp::GetJobStatusRequest* request,
+                                              mcp::GetJobStatusResponse* response)
+{
+    try
+    {
+        nlohmann::json params = protoToJson(*request);
+        nlohmann::json result = dispatch("get_job_status", &commandHandler::getJobStatus, params);
+
+        jsonToProto(result, response);
+
+        return grpc::Status::OK;
+    }
+    catch (const std::exception& e)
+    {
+        return {grpc::StatusCode::INTERNAL, e.what()};
+    }
+}
+
+grpc::Status grpcServerStrategy::CancelJob(grpc::ServerContext* context, const mcp::CancelJobRequest* request,
+                                           mcp::CancelJobResponse* response)
+{
+    try
+    {
+        nlohmann::json params = protoToJson(*request);
+        nlohmann::json result = dispatch("cancel_job", &commandHandler::cancelJob, params);
+
+        jsonToProto(result, response);
+
+        return grpc::Status::OK;
+    }
+    catch (const std::exception& e)
+    {
+        return {grpc::StatusCode::INTERNAL, e.what()};
+    }
+}
+
+grpc::Status grpcServerStrategy::UpdateObject(grpc::ServerContext* context, const mcp::UpdateObjectRequest* request,
+                                              mcp::UpdateObjectResponse* response)
+{
+    try
+    {
+        nlohmann::json params = protoToJson(*request);
+        nlohmann::json result = dispatch("update_object", &commandHandler::updateObject, params);
+
+        jsonToProto(result, response);
+
+        return grpc::Status::OK;
+    }
+    catch (const std::exception& e)
+    {
+        return {grpc::StatusCode::INTERNAL, e.what()};
+    }
+}
+
+grpc::Status grpcServerStrategy::QueryRegion(grpc::ServerContext* context, const mcp::QueryRegionRequest* request,
+                                             mcp::QueryRegionResponse* response)
+{
+    try
+    {
+        nlohmann::json params = protoToJson(*request);
+        nlohmann::json result = dispatch("query_region", &commandHandler::queryRegion, params);
+
+        jsonToProto(result, response);
+
+        return grpc::Status::OK;
+    }
+    catch (const std::exception& e)
+    {
+        return {grpc::StatusCode::INTERNAL, e.what()};
+    }
+}
+
+grpc::Status grpcServerStrategy::Raycast(grpc::ServerContext* context, const mcp::RaycastRequest* request,
+                                         mcp::RaycastResponse* response)
+{
+    try
+    {
+        nlohmann::json params = protoToJson(*request);
+        nlohmann::json result = dispatch("raycast", &commandHandler::raycast, params);
 
         jsonToProto(result, response);
 
@@ -254,6 +456,22 @@ nlohmann::json grpcServerStrategy::protoToJson(const mcp::ExecuteSoftwareCommand
     json["command"] = request.command();
 
     // Convert params to kwargs-style
+    nlohmann::json kwargs;
+    for (const auto& param : request.params())
+    {
+        kwargs[param.key()] = param.value();
+    }
+    json["kwargs"] = kwargs.dump();
+    json["async"] = request.run_async();
+
+    return json;
+}
+
+nlohmann::json grpcServerStrategy::protoToJson(const mcp::RenderStreamRequest& request)
+{
+    nlohmann::json json;
+    json["command"] = "render";
+
     nlohmann::json kwargs;
     for (const auto& param : request.params())
     {
@@ -271,6 +489,13 @@ nlohmann::json grpcServerStrategy::protoToJson(const mcp::SaveProjectRequest& re
     {
         json["filename"] = request.filename();
     }
+    if (!request.mode().empty())
+    {
+        json["mode"] = request.mode();
+    }
+    json["threads"] = request.threads() > 0 ? request.threads() : 1;
+    json["compress"] = request.compress();
+    json["async"] = request.run_async();
     return json;
 }
 
@@ -278,6 +503,100 @@ nlohmann::json grpcServerStrategy::protoToJson(const mcp::LoadProjectRequest& re
 {
     nlohmann::json json;
     json["filename"] = request.filename();
+    json["async"] = request.run_async();
+    return json;
+}
+
+nlohmann::json grpcServerStrategy::protoToJson(const mcp::GetJobStatusRequest& request)
+{
+    nlohmann::json json;
+    json["job_id"] = request.job_id();
+    return json;
+}
+
+nlohmann::json grpcServerStrategy::protoToJson(const mcp::CancelJobRequest& request)
+{
+    nlohmann::json json;
+    json["job_id"] = request.job_id();
+    return json;
+}
+
+nlohmann::json grpcServerStrategy::protoToJson(const mcp::GetMetricsRequest& request)
+{
+    nlohmann::json json;
+    json["reset"] = request.reset();
+    return json;
+}
+
+nlohmann::json grpcServerStrategy::protoToJson(const mcp::StopTraceRequest& request)
+{
+    nlohmann::json json = nlohmann::json::object();
+    if (!request.output_file().empty())
+    {
+        json["output_file"] = request.output_file();
+    }
+    return json;
+}
+
+nlohmann::json grpcServerStrategy::protoToJson(const mcp::StartProfileRequest& request)
+{
+    nlohmann::json json = nlohmann::json::object();
+    if (request.frequency() != 0)
+    {
+        json["frequency"] = request.frequency();
+    }
+    return json;
+}
+
+nlohmann::json grpcServerStrategy::protoToJson(const mcp::StopProfileRequest& request)
+{
+    nlohmann::json json = nlohmann::json::object();
+    if (!request.output_file().empty())
+    {
+        json["output_file"] = request.output_file();
+    }
+    return json;
+}
+
+nlohmann::json grpcServerStrategy::protoToJson(const mcp::MemoryReportRequest& request)
+{
+    nlohmann::json json;
+    json["async"] = request.run_async();
+    if (request.top() != 0)
+    {
+        json["top"] = request.top();
+    }
+    return json;
+}
+
+nlohmann::json grpcServerStrategy::protoToJson(const mcp::UpdateObjectRequest& request)
+{
+    nlohmann::json json;
+    json["id"] = request.object_id();
+    for (const auto& prop : request.properties())
+    {
+        json[prop.key()] = prop.value();
+    }
+    return json;
+}
+
+nlohmann::json grpcServerStrategy::protoToJson(const mcp::QueryRegionRequest& request)
+{
+    nlohmann::json json;
+    json["min"] = {request.min().x(), request.min().y(), request.min().z()};
+    json["max"] = {request.max().x(), request.max().y(), request.max().z()};
+    return json;
+}
+
+nlohmann::json grpcServerStrategy::protoToJson(const mcp::RaycastRequest& request)
+{
+    nlohmann::json json;
+    json["origin"] = {request.origin().x(), request.origin().y(), request.origin().z()};
+    json["direction"] = {request.direction().x(), request.direction().y(), request.direction().z()};
+    if (request.max_distance() > 0.0f)
+    {
+        json["max_distance"] = request.max_distance();
+    }
     return json;
 }
 
@@ -297,6 +616,154 @@ void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::SoftwareIn
     }
 }
 
+grpc::Status grpcServerStrategy::GetMetrics(grpc::ServerContext* context, const mcp::GetMetricsRequest* request,
+                                            mcp::GetMetricsResponse* response)
+{
+    try
+    {
+        nlohmann::json params = protoToJson(*request);
+        nlohmann::json result = dispatch("get_metrics", &commandHandler::getMetrics, params);
+
+        jsonToProto(result, response);
+
+        return grpc::Status::OK;
+    }
+    catch (const std::exception& e)
+    {
+        return {grpc::StatusCode::INTERNAL, e.what()};
+    }
+}
+
+grpc::Status grpcServerStrategy::StartTrace(grpc::ServerContext* context, const mcp::StartTraceRequest* request,
+                                            mcp::StartTraceResponse* response)
+{
+    try
+    {
+        nlohmann::json result = dispatch("trace_start", &commandHandler::traceStart, nlohmann::json::object());
+
+        jsonToProto(result, response);
+
+        return grpc::Status::OK;
+    }
+    catch (const std::exception& e)
+    {
+        return {grpc::StatusCode::INTERNAL, e.what()};
+    }
+}
+
+grpc::Status grpcServerStrategy::StopTrace(grpc::ServerContext* context, const mcp::StopTraceRequest* request,
+                                           mcp::StopTraceResponse* response)
+{
+    try
+    {
+        nlohmann::json params = protoToJson(*request);
+        nlohmann::json result = dispatch("trace_stop", &commandHandler::traceStop, params);
+
+        jsonToProto(result, response);
+
+        return grpc::Status::OK;
+    }
+    catch (const std::exception& e)
+    {
+        return {grpc::StatusCode::INTERNAL, e.what()};
+    }
+}
+
+grpc::Status grpcServerStrategy::StartProfile(grpc::ServerContext* context, const mcp::StartProfileRequest* request,
+                                              mcp::StartProfileResponse* response)
+{
+    try
+    {
+        nlohmann::json params = protoToJson(*request);
+        nlohmann::json result = dispatch("profile_start", &commandHandler::profileStart, params);
+
+        jsonToProto(result, response);
+
+        return grpc::Status::OK;
+    }
+    catch (const std::exception& e)
+    {
+        return {grpc::StatusCode::INTERNAL, e.what()};
+    }
+}
+
+grpc::Status grpcServerStrategy::StopProfile(grpc::ServerContext* context, const mcp::StopProfileRequest* request,
+                                             mcp::StopProfileResponse* response)
+{
+    try
+    {
+        nlohmann::json params = protoToJson(*request);
+        nlohmann::json result = dispatch("profile_stop", &commandHandler::profileStop, params);
+
+        jsonToProto(result, response);
+
+        return grpc::Status::OK;
+    }
+    catch (const std::exception& e)
+    {
+        return {grpc::StatusCode::INTERNAL, e.what()};
+    }
+}
+
+grpc::Status grpcServerStrategy::MemoryReport(grpc::ServerContext* context, const mcp::MemoryReportRequest* request,
+                                              mcp::MemoryReportResponse* response)
+{
+    try
+    {
+        nlohmann::json params = protoToJson(*request);
+        nlohmann::json result = dispatch("memory_report", &commandHandler::memoryReport, params);
+
+        jsonToProto(result, response);
+
+        return grpc::Status::OK;
+    }
+    catch (const std::exception& e)
+    {
+        return {grpc::StatusCode::INTERNAL, e.what()};
+    }
+}
+
+nlohmann::json grpcServerStrategy::dispatch(std::string_view command,
+                                            nlohmann::json (commandHandler::*method)(const nlohmann::json&),
+                                            const nlohmann::json& params)
+{
+    traceSpan span("grpc.request", "grpc");
+    handler_.metrics().add(runtimeMetrics::counter::grpcRequests);
+    runtimeMetrics::commandStats* stats = commands_.find(command)->second;
+    perfCounters::sample countersBefore = perfCounters::read();
+    allocationTracker::sample allocationsBefore = allocationTracker::read();
+    auto start = std::chrono::steady_clock::now();
+    try
+    {
+        // gRPC reads, parses and sends on its own, so only the handler's time is attributed
+        requestPhases phases(start);
+        nlohmann::json result = (handler_.*method)(params);
+        phases.mark(requestPhases::phase::execute);
+        stats->latency_.record(phases.totalNanoseconds());
+        stats->allocations_.add(allocationsBefore, allocationTracker::read());
+        stats->counters_.add(countersBefore, perfCounters::read());
+        handler_.slowLog().record("grpc", command, phases);
+        if (result.contains("error"))
+        {
+            handler_.metrics().add(runtimeMetrics::counter::failedRequests);
+        }
+        return result;
+    }
+    catch (const std::exception& e)
+    {
+        logger::error("grpc", "Command failed", {{"command", std::string(command)}, {"error", e.what()}});
+        stats->latency_.record(elapsedNanoseconds(start));
+        handler_.metrics().add(runtimeMetrics::counter::failedRequests);
+        throw;
+    }
+}
+
+uint64_t grpcServerStrategy::elapsedNanoseconds(std::chrono::steady_clock::time_point start)
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
 void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::SoftwareStatus* status)
 {
     if (json.contains("running")) status->set_running(json["running"].get<bool>());
@@ -304,6 +771,19 @@ void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::SoftwareSt
     if (json.contains("object_count")) status->set_object_count(json["object_count"].get<int32_t>());
     if (json.contains("memory_usage")) status->set_memory_usage(json["memory_usage"].get<std::string>());
     if (json.contains("uptime")) status->set_uptime(json["uptime"].get<std::string>());
+    if (json.contains("rss_bytes")) status->set_rss_bytes(json["rss_bytes"].get<uint64_t>());
+    if (json.contains("peak_rss_bytes")) status->set_peak_rss_bytes(json["peak_rss_bytes"].get<uint64_t>());
+    if (json.contains("heap_bytes")) status->set_heap_bytes(json["heap_bytes"].get<uint64_t>());
+    if (json.contains("uptime_seconds")) status->set_uptime_seconds(json["uptime_seconds"].get<double>());
+    if (json.contains("socket_requests")) status->set_socket_requests(json["socket_requests"].get<uint64_t>());
+    if (json.contains("grpc_requests")) status->set_grpc_requests(json["grpc_requests"].get<uint64_t>());
+    if (json.contains("failed_requests")) status->set_failed_requests(json["failed_requests"].get<uint64_t>());
+    if (json.contains("connections_accepted"))
+        status->set_connections_accepted(json["connections_accepted"].get<uint64_t>());
+    if (json.contains("active_connections"))
+        status->set_active_connections(json["active_connections"].get<int64_t>());
+    if (json.contains("jobs_queued")) status->set_jobs_queued(json["jobs_queued"].get<uint64_t>());
+    if (json.contains("jobs_running")) status->set_jobs_running(json["jobs_running"].get<uint64_t>());
 }
 
 void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::CreateObjectResponse* response)
@@ -375,6 +855,38 @@ void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::ExecuteSof
     if (json.contains("error")) response->set_error(json["error"].get<std::string>());
     if (json.contains("message")) response->set_message(json["message"].get<std::string>());
     if (json.contains("output_file")) response->set_output_file(json["output_file"].get<std::string>());
+    if (json.contains("job_id")) response->set_job_id(json["job_id"].get<std::string>());
+    if (json.contains("cache_hit")) response->set_cache_hit(json["cache_hit"].get<bool>());
+    if (json.contains("shm_name")) response->set_shm_name(json["shm_name"].get<std::string>());
+    if (json.contains("frame")) response->set_frame(json["frame"].get<uint64_t>());
+    if (json.contains("renders"))
+    {
+        for (const auto& render : json["renders"])
+        {
+            auto* camera = response->add_renders();
+            camera->set_camera_id(render.value("camera_id", ""));
+            camera->set_output_file(render.value("output_file", ""));
+            camera->set_shm_name(render.value("shm_name", ""));
+            camera->set_frame(render.value("frame", static_cast<uint64_t>(0)));
+            camera->set_tiles_traced(render.value("tiles_traced", static_cast<int64_t>(0)));
+            camera->set_render_ms(render.value("render_ms", 0.0));
+            camera->set_cache_hit(render.value("cache_hit", false));
+        }
+    }
+}
+
+void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::RenderStreamResponse* response)
+{
+    if (json.contains("success")) response->set_success(json["success"].get<bool>());
+    if (json.contains("error")) response->set_error(json["error"].get<std::string>());
+    if (json.value("success", false)) response->set_completion_percent(100.0);
+    response->set_done(true);
+    if (json.contains("output_file")) response->set_output_file(json["output_file"].get<std::string>());
+    if (json.contains("width")) response->set_width(json["width"].get<int32_t>());
+    if (json.contains("height")) response->set_height(json["height"].get<int32_t>());
+    if (json.contains("render_ms")) response->set_render_ms(json["render_ms"].get<double>());
+    if (json.contains("shm_name")) response->set_shm_name(json["shm_name"].get<std::string>());
+    if (json.contains("frame")) response->set_frame(json["frame"].get<uint64_t>());
 }
 
 void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::SaveProjectResponse* response)
@@ -383,6 +895,8 @@ void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::SaveProjec
     if (json.contains("error")) response->set_error(json["error"].get<std::string>());
     if (json.contains("message")) response->set_message(json["message"].get<std::string>());
     if (json.contains("filename")) response->set_filename(json["filename"].get<std::string>());
+    if (json.contains("job_id")) response->set_job_id(json["job_id"].get<std::string>());
+    if (json.contains("mode")) response->set_mode(json["mode"].get<std::string>());
 }
 
 void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::LoadProjectResponse* response)
@@ -392,4 +906,246 @@ void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::LoadProjec
     if (json.contains("message")) response->set_message(json["message"].get<std::string>());
     if (json.contains("filename")) response->set_filename(json["filename"].get<std::string>());
     if (json.contains("objects_loaded")) response->set_objects_loaded(json["objects_loaded"].get<int32_t>());
+    if (json.contains("job_id")) response->set_job_id(json["job_id"].get<std::string>());
+}
+
+void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::GetJobStatusResponse* response)
+{
+    if (json.contains("success")) response->set_success(json["success"].get<bool>());
+    if (json.contains("error")) response->set_error(json["error"].get<std::string>());
+    if (json.contains("job_id")) response->set_job_id(json["job_id"].get<std::string>());
+    if (json.contains("kind")) response->set_kind(json["kind"].get<std::string>());
+    if (json.contains("state")) response->set_state(json["state"].get<std::string>());
+    if (json.contains("result")) response->set_result(json["result"].dump());
+    if (json.contains("progress")) response->set_progress(json["progress"].get<double>());
+}
+
+void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::CancelJobResponse* response)
+{
+    if (json.contains("success")) response->set_success(json["success"].get<bool>());
+    if (json.contains("error")) response->set_error(json["error"].get<std::string>());
+    if (json.contains("message")) response->set_message(json["message"].get<std::string>());
+    if (json.contains("job_id")) response->set_job_id(json["job_id"].get<std::string>());
+}
+
+void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::GetMetricsResponse* response)
+{
+    if (json.contains("success")) response->set_success(json["success"].get<bool>());
+    if (json.contains("error")) response->set_error(json["error"].get<std::string>());
+    if (json.contains("commands"))
+    {
+        for (const auto& entry : json["commands"])
+        {
+            auto* command = response->add_commands();
+            command->set_transport(entry["transport"].get<std::string>());
+            command->set_command(entry["command"].get<std::string>());
+            command->set_count(entry["count"].get<uint64_t>());
+            command->set_mean_us(entry["mean_us"].get<double>());
+            command->set_p50_us(entry["p50_us"].get<double>());
+            command->set_p90_us(entry["p90_us"].get<double>());
+            command->set_p99_us(entry["p99_us"].get<double>());
+            command->set_p999_us(entry["p999_us"].get<double>());
+            command->set_max_us(entry["max_us"].get<double>());
+            if (entry.contains("allocations"))
+            {
+                const auto& counts = entry["allocations"];
+                auto* allocations = command->mutable_allocations();
+                allocations->set_measured(counts["measured"].get<uint64_t>());
+                allocations->set_allocations(counts["allocations"].get<uint64_t>());
+                allocations->set_bytes(counts["bytes"].get<uint64_t>());
+                allocations->set_frees(counts["frees"].get<uint64_t>());
+                allocations->set_allocations_per_request(counts["allocations_per_request"].get<double>());
+                allocations->set_bytes_per_request(counts["bytes_per_request"].get<double>());
+            }
+            if (entry.contains("hardware"))
+            {
+                const auto& counters = entry["hardware"];
+                auto* hardware = command->mutable_hardware();
+                hardware->set_measured(counters["measured"].get<uint64_t>());
+                hardware->set_cycles(counters["cycles"].get<uint64_t>());
+                hardware->set_instructions(counters["instructions"].get<uint64_t>());
+                hardware->set_cache_misses(counters["cache_misses"].get<uint64_t>());
+                hardware->set_branch_misses(counters["branch_misses"].get<uint64_t>());
+                hardware->set_ipc(counters["ipc"].get<double>());
+                hardware->set_cache_misses_per_kilo_instruction(
+                    counters["cache_misses_per_kilo_instruction"].get<double>());
+            }
+        }
+    }
+    if (json.contains("hardware_counters")) response->set_hardware_counters(json["hardware_counters"].get<bool>());
+    if (json.contains("allocation_tracking"))
+        response->set_allocation_tracking(json["allocation_tracking"].get<bool>());
+}
+
+void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::StartTraceResponse* response)
+{
+    if (json.contains("success")) response->set_success(json["success"].get<bool>());
+    if (json.contains("error")) response->set_error(json["error"].get<std::string>());
+    if (json.contains("message")) response->set_message(json["message"].get<std::string>());
+}
+
+void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::StopTraceResponse* response)
+{
+    if (json.contains("success")) response->set_success(json["success"].get<bool>());
+    if (json.contains("error")) response->set_error(json["error"].get<std::string>());
+    if (json.contains("message")) response->set_message(json["message"].get<std::string>());
+    if (json.contains("output_file")) response->set_output_file(json["output_file"].get<std::string>());
+    if (json.contains("events")) response->set_events(json["events"].get<uint64_t>());
+    if (json.contains("threads")) response->set_threads(json["threads"].get<uint64_t>());
+    if (json.contains("overwritten_events"))
+        response->set_overwritten_events(json["overwritten_events"].get<uint64_t>());
+    if (json.contains("dropped_threads")) response->set_dropped_threads(json["dropped_threads"].get<uint64_t>());
+}
+
+void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::StartProfileResponse* response)
+{
+    if (json.contains("success")) response->set_success(json["success"].get<bool>());
+    if (json.contains("error")) response->set_error(json["error"].get<std::string>());
+    if (json.contains("message")) response->set_message(json["message"].get<std::string>());
+    if (json.contains("frequency")) response->set_frequency(json["frequency"].get<int32_t>());
+}
+
+void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::StopProfileResponse* response)
+{
+    if (json.contains("success")) response->set_success(json["success"].get<bool>());
+    if (json.contains("error")) response->set_error(json["error"].get<std::string>());
+    if (json.contains("message")) response->set_message(json["message"].get<std::string>());
+    if (json.contains("output_file")) response->set_output_file(json["output_file"].get<std::string>());
+    if (json.contains("samples")) response->set_samples(json["samples"].get<uint64_t>());
+    if (json.contains("dropped_samples")) response->set_dropped_samples(json["dropped_samples"].get<uint64_t>());
+    if (json.contains("stacks")) response->set_stacks(json["stacks"].get<uint64_t>());
+    if (json.contains("frequency")) response->set_frequency(json["frequency"].get<int32_t>());
+    if (json.contains("duration_seconds")) response->set_duration_seconds(json["duration_seconds"].get<double>());
+    if (json.contains("hottest"))
+    {
+        for (const auto& function : json["hottest"])
+        {
+            mcp::HotFunction* hot = response->add_hottest();
+            hot->set_function(function.value("function", ""));
+            hot->set_samples(function.value("samples", static_cast<uint64_t>(0)));
+        }
+    }
+}
+
+void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::MemoryReportResponse* response)
+{
+    if (json.contains("success")) response->set_success(json["success"].get<bool>());
+    if (json.contains("error")) response->set_error(json["error"].get<std::string>());
+    if (json.contains("message")) response->set_message(json["message"].get<std::string>());
+    if (json.contains("job_id")) response->set_job_id(json["job_id"].get<std::string>());
+    if (json.contains("objects")) response->set_objects(json["objects"].get<uint64_t>());
+    if (json.contains("total_bytes")) response->set_total_bytes(json["total_bytes"].get<uint64_t>());
+    if (json.contains("object_bytes")) response->set_object_bytes(json["object_bytes"].get<uint64_t>());
+    if (json.contains("types"))
+    {
+        for (const auto& type : json["types"])
+        {
+            mcp::TypeFootprint* footprint = response->add_types();
+            footprint->set_type(type.value("type", ""));
+            footprint->set_objects(type.value("objects", static_cast<uint64_t>(0)));
+            footprint->set_bytes(type.value("bytes", static_cast<uint64_t>(0)));
+            footprint->set_property_bytes(type.value("property_bytes", static_cast<uint64_t>(0)));
+            footprint->set_string_bytes(type.value("string_bytes", static_cast<uint64_t>(0)));
+        }
+    }
+    if (json.contains("properties"))
+    {
+        for (const auto& property : json["properties"])
+        {
+            mcp::PropertyFootprint* footprint = response->add_properties();
+            footprint->set_name(property.value("name", ""));
+            footprint->set_objects(property.value("objects", static_cast<uint64_t>(0)));
+            footprint->set_bytes(property.value("bytes", static_cast<uint64_t>(0)));
+        }
+    }
+    if (json.contains("property_names")) response->set_property_names(json["property_names"].get<uint64_t>());
+    if (json.contains("index"))
+    {
+        const auto& index = json["index"];
+        mcp::IndexFootprint* footprint = response->mutable_index();
+        footprint->set_built(index.value("built", false));
+        footprint->set_slots(index.value("slots", static_cast<uint64_t>(0)));
+        footprint->set_bytes(index.value("bytes", static_cast<uint64_t>(0)));
+        footprint->set_bvh_bytes(index.value("bvh_bytes", static_cast<uint64_t>(0)));
+        footprint->set_slot_bytes(index.value("slot_bytes", static_cast<uint64_t>(0)));
+        footprint->set_packed_bytes(index.value("packed_bytes", static_cast<uint64_t>(0)));
+        footprint->set_change_tracking_bytes(index.value("change_tracking_bytes", static_cast<uint64_t>(0)));
+    }
+    if (json.contains("render_cache"))
+    {
+        const auto& cache = json["render_cache"];
+        mcp::RenderCacheFootprint* footprint = response->mutable_render_cache();
+        footprint->set_bytes(cache.value("bytes", static_cast<uint64_t>(0)));
+        footprint->set_memory_entries(cache.value("memory_entries", static_cast<uint64_t>(0)));
+        footprint->set_image_bytes(cache.value("image_bytes", static_cast<uint64_t>(0)));
+        footprint->set_overhead_bytes(cache.value("overhead_bytes", static_cast<uint64_t>(0)));
+        footprint->set_disk_entries(cache.value("disk_entries", static_cast<uint64_t>(0)));
+        footprint->set_disk_bytes(cache.value("disk_bytes", static_cast<uint64_t>(0)));
+    }
+    if (json.contains("render_frames"))
+    {
+        response->set_render_frames(json["render_frames"].value("frames", static_cast<uint64_t>(0)));
+        response->set_render_frame_bytes(json["render_frames"].value("bytes", static_cast<uint64_t>(0)));
+    }
+    if (json.contains("jobs"))
+    {
+        response->set_jobs(json["jobs"].value("jobs", static_cast<uint64_t>(0)));
+        response->set_job_bytes(json["jobs"].value("bytes", static_cast<uint64_t>(0)));
+        response->set_job_result_bytes(json["jobs"].value("result_bytes", static_cast<uint64_t>(0)));
+    }
+    if (json.contains("rss_bytes")) response->set_rss_bytes(json["rss_bytes"].get<uint64_t>());
+    if (json.contains("heap_bytes")) response->set_heap_bytes(json["heap_bytes"].get<uint64_t>());
+}
+
+void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::UpdateObjectResponse* response)
+{
+    if (json.contains("success")) response->set_success(json["success"].get<bool>());
+    if (json.contains("error")) response->set_error(json["error"].get<std::string>());
+    if (json.contains("object_id")) response->set_object_id(json["object_id"].get<std::string>());
+
+    if (json.contains("object"))
+    {
+        auto* obj = response->mutable_object();
+        const auto& object_info = json["object"];
+        if (object_info.contains("name")) obj->set_name(object_info["name"].get<std::string>());
+        if (object_info.contains("type")) obj->set_type(object_info["type"].get<std::string>());
+        if (object_info.contains("properties"))
+        {
+            for (const auto& item : object_info["properties"].items())
+            {
+                auto* prop = obj->add_properties();
+                prop->set_key(item.key());
+                prop->set_value(item.value().get<std::string>());
+            }
+        }
+    }
+}
+
+void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::QueryRegionResponse* response)
+{
+    if (json.contains("success")) response->set_success(json["success"].get<bool>());
+    if (json.contains("error")) response->set_error(json["error"].get<std::string>());
+    if (json.contains("object_ids"))
+    {
+        for (const auto& id : json["object_ids"])
+        {
+            response->add_object_ids(id.get<std::string>());
+        }
+    }
+}
+
+void grpcServerStrategy::jsonToProto(const nlohmann::json& json, mcp::RaycastResponse* response)
+{
+    if (json.contains("success")) response->set_success(json["success"].get<bool>());
+    if (json.contains("error")) response->set_error(json["error"].get<std::string>());
+    if (json.contains("hit")) response->set_hit(json["hit"].get<bool>());
+    if (json.contains("object_id")) response->set_object_id(json["object_id"].get<std::string>());
+    if (json.contains("distance")) response->set_distance(json["distance"].get<float>());
+    if (json.contains("point"))
+    {
+        auto* point = response->mutable_point();
+        point->set_x(json["point"][0].get<float>());
+        point->set_y(json["point"][1].get<float>());
+        point->set_z(json["point"][2].get<float>());
+    }
 }
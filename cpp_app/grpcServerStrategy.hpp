@@ -1,6 +1,9 @@
 #pragma once
 
+#include <chrono>
+#include <map>
 #include <memory>
+#include <string_view>
 
 #include "grpcpp/grpcpp.h"
 #include "mcp_service.grpc.pb.h"
@@ -28,6 +31,9 @@ class grpcServerStrategy : public serverStrategy, public mcp::MCPService::Servic
     grpc::Status DeleteObject(grpc::ServerContext* context, const mcp::DeleteObjectRequest* request,
                               mcp::DeleteObjectResponse* response) override;
 
+    grpc::Status UpdateObject(grpc::ServerContext* context, const mcp::UpdateObjectRequest* request,
+                              mcp::UpdateObjectResponse* response) override;
+
     grpc::Status ListObjects(grpc::ServerContext* context, const mcp::ListObjectsRequest* request,
                              mcp::ListObjectsResponse* response) override;
 
@@ -37,23 +43,73 @@ class grpcServerStrategy : public serverStrategy, public mcp::MCPService::Servic
     grpc::Status ExecuteSoftwareCommand(grpc::ServerContext* context, const mcp::ExecuteSoftwareCommandRequest* request,
                                         mcp::ExecuteSoftwareCommandResponse* response) override;
 
+    grpc::Status RenderStream(grpc::ServerContext* context, const mcp::RenderStreamRequest* request,
+                              grpc::ServerWriter<mcp::RenderStreamResponse>* writer) override;
+
     grpc::Status SaveProject(grpc::ServerContext* context, const mcp::SaveProjectRequest* request,
                              mcp::SaveProjectResponse* response) override;
 
     grpc::Status LoadProject(grpc::ServerContext* context, const mcp::LoadProjectRequest* request,
                              mcp::LoadProjectResponse* response) override;
 
+    grpc::Status GetJobStatus(grpc::ServerContext* context, const mcp::GetJobStatusRequest* request,
+                              mcp::GetJobStatusResponse* response) override;
+
+    grpc::Status CancelJob(grpc::ServerContext* context, const mcp::CancelJobRequest* request,
+                           mcp::CancelJobResponse* response) override;
+
+    grpc::Status QueryRegion(grpc::ServerContext* context, const mcp::QueryRegionRequest* request,
+                             mcp::QueryRegionResponse* response) override;
+
+    grpc::Status Raycast(grpc::ServerContext* context, const mcp::RaycastRequest* request,
+                         mcp::RaycastResponse* response) override;
+
+    grpc::Status GetMetrics(grpc::ServerContext* context, const mcp::GetMetricsRequest* request,
+                            mcp::GetMetricsResponse* response) override;
+
+    grpc::Status StartTrace(grpc::ServerContext* context, const mcp::StartTraceRequest* request,
+                            mcp::StartTraceResponse* response) override;
+
+    grpc::Status StopTrace(grpc::ServerContext* context, const mcp::StopTraceRequest* request,
+                           mcp::StopTraceResponse* response) override;
+
+    grpc::Status StartProfile(grpc::ServerContext* context, const mcp::StartProfileRequest* request,
+                              mcp::StartProfileResponse* response) override;
+
+    grpc::Status StopProfile(grpc::ServerContext* context, const mcp::StopProfileRequest* request,
+                             mcp::StopProfileResponse* response) override;
+
+    grpc::Status MemoryReport(grpc::ServerContext* context, const mcp::MemoryReportRequest* request,
+                              mcp::MemoryReportResponse* response) override;
+
   private:
     std::unique_ptr<grpc::Server> server_;
     std::string address_;
+    std::map<std::string, runtimeMetrics::commandStats*, std::less<>> commands_;  // Filled by the constructor
+
+    // Runs a handler method, counting the request, whether it failed and how long it took
+    nlohmann::json dispatch(std::string_view command, nlohmann::json (commandHandler::*method)(const nlohmann::json&),
+                            const nlohmann::json& params);
+    static uint64_t elapsedNanoseconds(std::chrono::steady_clock::time_point start);
 
     // Helper methods for conversion between protobuf and JSON
     static nlohmann::json protoToJson(const mcp::CreateObjectRequest& request);
     static nlohmann::json protoToJson(const mcp::DeleteObjectRequest& request);
     static nlohmann::json protoToJson(const mcp::GetObjectInfoRequest& request);
     static nlohmann::json protoToJson(const mcp::ExecuteSoftwareCommandRequest& request);
+    static nlohmann::json protoToJson(const mcp::RenderStreamRequest& request);
     static nlohmann::json protoToJson(const mcp::SaveProjectRequest& request);
     static nlohmann::json protoToJson(const mcp::LoadProjectRequest& request);
+    static nlohmann::json protoToJson(const mcp::GetJobStatusRequest& request);
+    static nlohmann::json protoToJson(const mcp::CancelJobRequest& request);
+    static nlohmann::json protoToJson(const mcp::GetMetricsRequest& request);
+    static nlohmann::json protoToJson(const mcp::StopTraceRequest& request);
+    static nlohmann::json protoToJson(const mcp::StartProfileRequest& request);
+    static nlohmann::json protoToJson(const mcp::StopProfileRequest& request);
+    static nlohmann::json protoToJson(const mcp::MemoryReportRequest& request);
+    static nlohmann::json protoToJson(const mcp::UpdateObjectRequest& request);
+    static nlohmann::json protoToJson(const mcp::QueryRegionRequest& request);
+    static nlohmann::json protoToJson(const mcp::RaycastRequest& request);
 
     static void jsonToProto(const nlohmann::json& json, mcp::SoftwareInfo* info);
     static void jsonToProto(const nlohmann::json& json, mcp::SoftwareStatus* status);
@@ -62,6 +118,18 @@ class grpcServerStrategy : public serverStrategy, public mcp::MCPService::Servic
     static void jsonToProto(const nlohmann::json& json, mcp::ListObjectsResponse* response);
     static void jsonToProto(const nlohmann::json& json, mcp::GetObjectInfoResponse* response);
     static void jsonToProto(const nlohmann::json& json, mcp::ExecuteSoftwareCommandResponse* response);
+    static void jsonToProto(const nlohmann::json& json, mcp::RenderStreamResponse* response);
     static void jsonToProto(const nlohmann::json& json, mcp::SaveProjectResponse* response);
     static void jsonToProto(const nlohmann::json& json, mcp::LoadProjectResponse* response);
+    static void jsonToProto(const nlohmann::json& json, mcp::GetJobStatusResponse* response);
+    static void jsonToProto(const nlohmann::json& json, mcp::CancelJobResponse* response);
+    static void jsonToProto(const nlohmann::json& json, mcp::GetMetricsResponse* response);
+    static void jsonToProto(const nlohmann::json& json, mcp::StartTraceResponse* response);
+    static void jsonToProto(const nlohmann::json& json, mcp::StopTraceResponse* response);
+    static void jsonToProto(const nlohmann::json& json, mcp::StartProfileResponse* response);
+    static void jsonToProto(const nlohmann::json& json, mcp::StopProfileResponse* response);
+    static void jsonToProto(const nlohmann::json& json, mcp::MemoryReportResponse* response);
+    static void jsonToProto(const nlohmann::json& json, mcp::UpdateObjectResponse* response);
+    static void jsonToProto(const nlohmann::json& json, mcp::QueryRegionResponse* response);
+    static void jsonToProto(const nlohmann::json& json, mcp::RaycastResponse* response);
 };
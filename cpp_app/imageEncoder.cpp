@@ -0,0 +1,534 @@
+#include "imageEncoder.hpp"
+#include "threadPool.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <fstream>
+
+namespace
+{
+constexpr size_t kMaxStoredBlock = 65535;
+constexpr int kBytesPerPixel = 3;
+
+// LZ77 parameters for the fixed-Huffman deflate
+constexpr int kHashBits = 15;
+constexpr size_t kWindowSize = 32768;
+constexpr size_t kMinMatch = 3;
+constexpr size_t kMaxMatch = 258;
+constexpr int kMaxChain = 16;  // Candidates tried per position; trades ratio for speed
+
+constexpr uint16_t kLengthBase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                      31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr uint8_t kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                      2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr uint16_t kDistanceBase[30] = {1,    2,    3,    4,    5,    7,     9,     13,    17,    25,
+                                        33,   49,   65,   97,   129,  193,   257,   385,   513,   769,
+                                        1025, 1537, 2049, 3073, 4097, 6145,  8193,  12289, 16385, 24577};
+constexpr uint8_t kDistanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                        6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+std::array<uint32_t, 256> makeCrcTable()
+{
+    std::array<uint32_t, 256> table{};
+    for (uint32_t n = 0; n < 256; ++n)
+    {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k)
+        {
+            c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        table[n] = c;
+    }
+    return table;
+}
+
+uint32_t reverseBits(uint32_t code, int length)
+{
+    uint32_t reversed = 0;
+    for (int i = 0; i < length; ++i)
+    {
+        reversed = (reversed << 1) | ((code >> i) & 1);
+    }
+    return reversed;
+}
+
+// Fixed literal/length code of RFC 1951 section 3.2.6, bit-reversed for LSB-first output
+struct fixedCode
+{
+    uint16_t bits_;
+    uint8_t length_;
+};
+
+std::array<fixedCode, 288> makeFixedCodes()
+{
+    std::array<fixedCode, 288> codes{};
+    for (uint32_t symbol = 0; symbol < 288; ++symbol)
+    {
+        uint32_t code;
+        int length;
+        if (symbol < 144)
+        {
+            code = 0x30 + symbol;
+            length = 8;
+        }
+        else if (symbol < 256)
+        {
+            code = 0x190 + (symbol - 144);
+            length = 9;
+        }
+        else if (symbol < 280)
+        {
+            code = symbol - 256;
+            length = 7;
+        }
+        else
+        {
+            code = 0xc0 + (symbol - 280);
+            length = 8;
+        }
+        codes[symbol] = {static_cast<uint16_t>(reverseBits(code, length)), static_cast<uint8_t>(length)};
+    }
+    return codes;
+}
+
+// Deflate emits bits least significant first
+class bitWriter
+{
+  public:
+    explicit bitWriter(std::string& out) : out_(out), buffer_(0), count_(0)
+    {
+    }
+
+    void put(uint32_t bits, int length)
+    {
+        buffer_ |= static_cast<uint64_t>(bits) << count_;
+        count_ += length;
+        while (count_ >= 8)
+        {
+            out_.push_back(static_cast<char>(buffer_ & 0xff));
+            buffer_ >>= 8;
+            count_ -= 8;
+        }
+    }
+
+    void alignToByte()
+    {
+        if (count_ > 0)
+        {
+            put(0, 8 - count_);
+        }
+    }
+
+  private:
+    std::string& out_;
+    uint64_t buffer_;
+    int count_;
+};
+
+uint8_t paethPredictor(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc)
+    {
+        return static_cast<uint8_t>(a);
+    }
+    return static_cast<uint8_t>(pb <= pc ? b : c);
+}
+}  // namespace
+
+bool imageEncoder::parseFormat(const std::string& name, format& outFormat)
+{
+    if (name == "png")
+    {
+        outFormat = format::png;
+    }
+    else if (name == "png_stored")
+    {
+        outFormat = format::pngStored;
+    }
+    else if (name == "ppm")
+    {
+        outFormat = format::ppm;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+std::string imageEncoder::formatName(format value)
+{
+    switch (value)
+    {
+        case format::png:
+            return "png";
+        case format::pngStored:
+            return "png_stored";
+        case format::ppm:
+            return "ppm";
+    }
+    return "unknown";
+}
+
+bool imageEncoder::writePng(const std::string& filename, int width, int height, const std::vector<uint8_t>& rgb)
+{
+    return writeFile(filename, encodePng(width, height, rgb));
+}
+
+std::string imageEncoder::encode(format value, int width, int height, const std::vector<uint8_t>& rgb,
+                                 threadPool* pool)
+{
+    if (value == format::ppm)
+    {
+        return encodePpm(width, height, rgb);
+    }
+    return encodePng(width, height, rgb, pool, value == format::png);
+}
+
+bool imageEncoder::writeFile(const std::string& filename, const std::string& encoded)
+{
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        return false;
+    }
+    file.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+    file.close();
+    return !file.fail();
+}
+
+std::string imageEncoder::encodePng(int width, int height, const std::vector<uint8_t>& rgb, threadPool* pool,
+                                    bool compress)
+{
+    // Each band becomes a byte-aligned run of non-final deflate blocks in its own IDAT chunk, so
+    // bands are encoded independently and simply concatenated
+    int bandCount = 1;
+    if (pool)
+    {
+        int maxBands = std::max(1, height / kMinBandRows);
+        bandCount = std::min(maxBands, static_cast<int>(pool->size()) * 2);
+    }
+    int bandRows = (height + bandCount - 1) / bandCount;
+    bandCount = (height + bandRows - 1) / bandRows;
+
+    std::vector<band> bands(bandCount);
+    auto encodeBand = [&](size_t index)
+    {
+        int firstRow = static_cast<int>(index) * bandRows;
+        int endRow = std::min(height, firstRow + bandRows);
+        std::vector<uint8_t> filtered;
+        if (compress)
+        {
+            filterRows(rgb, width, firstRow, endRow, filtered);
+        }
+        else
+        {
+            // Filter type 0 (none) keeps the stored path a plain copy
+            size_t stride = static_cast<size_t>(width) * kBytesPerPixel;
+            filtered.reserve((stride + 1) * (endRow - firstRow));
+            for (int y = firstRow; y < endRow; ++y)
+            {
+                filtered.push_back(0);
+                filtered.insert(filtered.end(), rgb.begin() + y * stride, rgb.begin() + (y + 1) * stride);
+            }
+        }
+
+        std::string data;
+        if (index == 0)
+        {
+            data = {0x78, 0x01};  // zlib header: deflate, 32K window, no dictionary
+        }
+        if (compress)
+        {
+            deflateFixed(filtered.data(), filtered.size(), data);
+        }
+        else
+        {
+            deflateStored(filtered.data(), filtered.size(), data);
+        }
+        appendChunk(bands[index].chunk_, "IDAT", data);
+        bands[index].adler_ = adler32(filtered.data(), filtered.size());
+        bands[index].rawSize_ = filtered.size();
+    };
+    if (pool && bandCount > 1)
+    {
+        pool->parallelFor(bands.size(), encodeBand);
+    }
+    else
+    {
+        for (size_t index = 0; index < bands.size(); ++index)
+        {
+            encodeBand(index);
+        }
+    }
+
+    // The stream ends with an empty final stored block and the checksum of all scanlines
+    uint32_t adler = 1;
+    for (const band& b : bands)
+    {
+        adler = adler32Combine(adler, b.adler_, b.rawSize_);
+    }
+    std::string trailer = {1, 0, 0, static_cast<char>(0xff), static_cast<char>(0xff)};
+    appendU32(trailer, adler);
+
+    std::string header;
+    appendU32(header, static_cast<uint32_t>(width));
+    appendU32(header, static_cast<uint32_t>(height));
+    header += {8, 2, 0, 0, 0};  // 8-bit depth, truecolour, default compression/filter, no interlace
+
+    std::string png = "\x89PNG\r\n\x1a\n";
+    appendChunk(png, "IHDR", header);
+    for (const band& b : bands)
+    {
+        png += b.chunk_;
+    }
+    appendChunk(png, "IDAT", trailer);
+    appendChunk(png, "IEND", "");
+    return png;
+}
+
+std::string imageEncoder::encodePpm(int width, int height, const std::vector<uint8_t>& rgb)
+{
+    std::string ppm = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    ppm.append(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+    return ppm;
+}
+
+void imageEncoder::filterRows(const std::vector<uint8_t>& rgb, int width, int firstRow, int endRow,
+                              std::vector<uint8_t>& outFiltered)
+{
+    // Per row, keep the filter with the smallest sum of absolute residuals (the usual PNG heuristic)
+    size_t stride = static_cast<size_t>(width) * kBytesPerPixel;
+    std::vector<uint8_t> zeroRow(stride, 0);
+    std::array<std::vector<uint8_t>, 5> candidates;
+    for (auto& candidate : candidates)
+    {
+        candidate.resize(stride);
+    }
+
+    outFiltered.clear();
+    outFiltered.reserve((stride + 1) * (endRow - firstRow));
+    for (int y = firstRow; y < endRow; ++y)
+    {
+        const uint8_t* row = rgb.data() + y * stride;
+        const uint8_t* prior = y > 0 ? rgb.data() + (y - 1) * stride : zeroRow.data();
+        for (size_t i = 0; i < stride; ++i)
+        {
+            uint8_t a = i >= kBytesPerPixel ? row[i - kBytesPerPixel] : 0;
+            uint8_t b = prior[i];
+            uint8_t c = i >= kBytesPerPixel ? prior[i - kBytesPerPixel] : 0;
+            candidates[0][i] = row[i];
+            candidates[1][i] = static_cast<uint8_t>(row[i] - a);
+            candidates[2][i] = static_cast<uint8_t>(row[i] - b);
+            candidates[3][i] = static_cast<uint8_t>(row[i] - ((a + b) >> 1));
+            candidates[4][i] = static_cast<uint8_t>(row[i] - paethPredictor(a, b, c));
+        }
+
+        size_t best = 0;
+        uint64_t bestCost = UINT64_MAX;
+        for (size_t filter = 0; filter < candidates.size(); ++filter)
+        {
+            uint64_t cost = 0;
+            for (uint8_t value : candidates[filter])
+            {
+                cost += static_cast<uint64_t>(std::abs(static_cast<int8_t>(value)));
+            }
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                best = filter;
+            }
+        }
+        outFiltered.push_back(static_cast<uint8_t>(best));
+        outFiltered.insert(outFiltered.end(), candidates[best].begin(), candidates[best].end());
+    }
+}
+
+void imageEncoder::deflateFixed(const uint8_t* data, size_t size, std::string& out)
+{
+    static const std::array<fixedCode, 288> codes = makeFixedCodes();
+    bitWriter writer(out);
+    writer.put(0, 1);  // Not the final block
+    writer.put(1, 2);  // Fixed Huffman codes
+
+    // Greedy LZ77 over hash chains; the previous-position ring only covers the 32K window
+    std::vector<int32_t> head(static_cast<size_t>(1) << kHashBits, -1);
+    std::vector<int32_t> previous(kWindowSize, -1);
+    auto hashAt = [data](size_t position)
+    {
+        uint32_t key = (data[position] << 16) | (data[position + 1] << 8) | data[position + 2];
+        return (key * 2654435761u) >> (32 - kHashBits);
+    };
+    auto insert = [&](size_t position)
+    {
+        uint32_t hash = hashAt(position);
+        previous[position & (kWindowSize - 1)] = head[hash];
+        head[hash] = static_cast<int32_t>(position);
+    };
+
+    size_t position = 0;
+    while (position < size)
+    {
+        size_t bestLength = 0;
+        size_t bestDistance = 0;
+        if (position + kMinMatch <= size)
+        {
+            size_t maxLength = std::min(kMaxMatch, size - position);
+            int32_t candidate = head[hashAt(position)];
+            for (int chain = 0; chain < kMaxChain && candidate >= 0; ++chain)
+            {
+                size_t distance = position - candidate;
+                if (distance >= kWindowSize)
+                {
+                    break;
+                }
+                if (data[candidate + bestLength] == data[position + bestLength])
+                {
+                    size_t length = 0;
+                    while (length < maxLength && data[candidate + length] == data[position + length])
+                    {
+                        ++length;
+                    }
+                    if (length > bestLength)
+                    {
+                        bestLength = length;
+                        bestDistance = distance;
+                        if (length == maxLength)
+                        {
+                            break;
+                        }
+                    }
+                }
+                int32_t next = previous[candidate & (kWindowSize - 1)];
+                if (next >= candidate)
+                {
+                    break;  // Slot was reused by a newer position
+                }
+                candidate = next;
+            }
+            insert(position);
+        }
+
+        if (bestLength < kMinMatch)
+        {
+            writer.put(codes[data[position]].bits_, codes[data[position]].length_);
+            ++position;
+            continue;
+        }
+
+        size_t lengthCode = std::upper_bound(kLengthBase, kLengthBase + 29, bestLength) - kLengthBase - 1;
+        const fixedCode& code = codes[257 + lengthCode];
+        writer.put(code.bits_, code.length_);
+        writer.put(static_cast<uint32_t>(bestLength - kLengthBase[lengthCode]), kLengthExtra[lengthCode]);
+
+        size_t distanceCode = std::upper_bound(kDistanceBase, kDistanceBase + 30, bestDistance) - kDistanceBase - 1;
+        writer.put(reverseBits(static_cast<uint32_t>(distanceCode), 5), 5);
+        writer.put(static_cast<uint32_t>(bestDistance - kDistanceBase[distanceCode]), kDistanceExtra[distanceCode]);
+
+        for (size_t i = 1; i < bestLength && position + i + kMinMatch <= size; ++i)
+        {
+            insert(position + i);
+        }
+        position += bestLength;
+    }
+    writer.put(codes[256].bits_, codes[256].length_);  // End of block
+
+    // Empty stored block to end on a byte boundary, as a zlib sync flush does
+    writer.put(0, 3);
+    writer.alignToByte();
+    out += {0, 0, static_cast<char>(0xff), static_cast<char>(0xff)};
+}
+
+void imageEncoder::deflateStored(const uint8_t* data, size_t size, std::string& out)
+{
+    // Non-final stored blocks; the caller terminates the stream
+    for (size_t offset = 0; offset < size; offset += kMaxStoredBlock)
+    {
+        size_t length = std::min(kMaxStoredBlock, size - offset);
+        out.push_back(0);
+        out.push_back(static_cast<char>(length & 0xff));
+        out.push_back(static_cast<char>(length >> 8));
+        out.push_back(static_cast<char>(~length & 0xff));
+        out.push_back(static_cast<char>((~length >> 8) & 0xff));
+        out.append(reinterpret_cast<const char*>(data) + offset, length);
+    }
+}
+
+uint32_t imageEncoder::crc32(const uint8_t* data, size_t size, uint32_t crc)
+{
+    static const std::array<uint32_t, 256> table = makeCrcTable();
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i)
+    {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t imageEncoder::adler32(const uint8_t* data, size_t size, uint32_t adler)
+{
+    // Reduce every 5552 bytes, the most that cannot overflow 32 bits
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+    while (size > 0)
+    {
+        size_t run = std::min<size_t>(size, 5552);
+        size -= run;
+        for (size_t i = 0; i < run; ++i)
+        {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+uint32_t imageEncoder::adler32Combine(uint32_t first, uint32_t second, size_t secondSize)
+{
+    // Checksum of the concatenation, from the checksums of both parts (as zlib's adler32_combine)
+    const uint32_t base = 65521;
+    uint32_t remainder = static_cast<uint32_t>(secondSize % base);
+    uint32_t sum1 = first & 0xffff;
+    uint32_t sum2 = static_cast<uint32_t>((static_cast<uint64_t>(remainder) * sum1) % base);
+    sum1 += (second & 0xffff) + base - 1;
+    sum2 += (first >> 16) + (second >> 16) + base - remainder;
+    if (sum1 >= base)
+    {
+        sum1 -= base;
+    }
+    if (sum1 >= base)
+    {
+        sum1 -= base;
+    }
+    if (sum2 >= (base << 1))
+    {
+        sum2 -= (base << 1);
+    }
+    if (sum2 >= base)
+    {
+        sum2 -= base;
+    }
+    return (sum2 << 16) | sum1;
+}
+
+void imageEncoder::appendU32(std::string& out, uint32_t value)
+{
+    out.push_back(static_cast<char>(value >> 24));
+    out.push_back(static_cast<char>((value >> 16) & 0xff));
+    out.push_back(static_cast<char>((value >> 8) & 0xff));
+    out.push_back(static_cast<char>(value & 0xff));
+}
+
+void imageEncoder::appendChunk(std::string& out, const char* type, const std::string& data)
+{
+    appendU32(out, static_cast<uint32_t>(data.size()));
+    std::string body = std::string(type, 4) + data;
+    out += body;
+    appendU32(out, crc32(reinterpret_cast<const uint8_t*>(body.data()), body.size()));
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class threadPool;
+
+// Writes 8-bit RGB framebuffers to image files. PNGs are filtered and deflated in row bands,
+// one band per task when a pool is given, and stitched into a single zlib stream.
+class imageEncoder
+{
+  public:
+    enum class format
+    {
+        png,        // Filtered and deflate-compressed
+        pngStored,  // Valid PNG with uncompressed deflate blocks; fastest PNG to produce
+        ppm         // Binary PPM (P6); raw pixels for local consumers
+    };
+
+    static bool parseFormat(const std::string& name, format& outFormat);
+    static std::string formatName(format value);
+
+    static bool writePng(const std::string& filename, int width, int height, const std::vector<uint8_t>& rgb);
+    static std::string encode(format value, int width, int height, const std::vector<uint8_t>& rgb,
+                              threadPool* pool = nullptr);
+    static std::string encodePng(int width, int height, const std::vector<uint8_t>& rgb, threadPool* pool = nullptr,
+                                 bool compress = true);
+    static std::string encodePpm(int width, int height, const std::vector<uint8_t>& rgb);
+    static bool writeFile(const std::string& filename, const std::string& encoded);
+
+  private:
+    static constexpr int kMinBandRows = 16;
+
+    // Encoded output of one band of rows
+    struct band
+    {
+        std::string chunk_;  // Complete IDAT chunk holding this band's deflate blocks
+        uint32_t adler_;     // Adler-32 of the band's filtered scanlines
+        size_t rawSize_;
+    };
+
+    static void filterRows(const std::vector<uint8_t>& rgb, int width, int firstRow, int endRow,
+                           std::vector<uint8_t>& outFiltered);
+    static void deflateFixed(const uint8_t* data, size_t size, std::string& out);
+    static void deflateStored(const uint8_t* data, size_t size, std::string& out);
+    static uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+    static uint32_t adler32(const uint8_t* data, size_t size, uint32_t adler = 1);
+    static uint32_t adler32Combine(uint32_t first, uint32_t second, size_t secondSize);
+    static void appendU32(std::string& out, uint32_t value);
+    static void appendChunk(std::string& out, const char* type, const std::string& data);
+};
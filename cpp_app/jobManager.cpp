@@ -0,0 +1,233 @@
+#include "jobManager.hpp"
+#include "memoryFootprint.hpp"
+#include "traceRecorder.hpp"
+#include <algorithm>
+
+jobManager::jobControl::jobControl() : progress_(0.0), cancelled_(false)
+{
+}
+
+void jobManager::jobControl::setProgress(double progress)
+{
+    progress_.store(std::min(1.0, std::max(0.0, progress)), std::memory_order_relaxed);
+}
+
+double jobManager::jobControl::progress() const
+{
+    return progress_.load(std::memory_order_relaxed);
+}
+
+bool jobManager::jobControl::cancelled() const
+{
+    return cancelled_.load(std::memory_order_relaxed);
+}
+
+void jobManager::jobControl::cancel()
+{
+    cancelled_.store(true, std::memory_order_relaxed);
+}
+
+jobManager::jobManager(size_t threads) : nextJobId_(1), running_(0), stopping_(false)
+{
+    for (size_t i = 0; i < std::max<size_t>(1, threads); ++i)
+    {
+        workers_.emplace_back(&jobManager::workerLoop, this);
+    }
+}
+
+jobManager::~jobManager()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_)
+    {
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+}
+
+std::string jobManager::submit(const std::string& kind, jobWork work)
+{
+    std::string id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = "job_" + std::to_string(nextJobId_++);
+        jobRecord& record = jobs_[id];
+        record.info_ = {id, kind, jobState::queued, 0.0, nlohmann::json::object()};
+        record.control_ = std::make_shared<jobControl>();
+        record.work_ = std::move(work);
+        queue_.push_back(id);
+    }
+    cv_.notify_one();
+    return id;
+}
+
+bool jobManager::getJob(const std::string& jobId, jobInfo& outInfo) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = jobs_.find(jobId);
+    if (it != jobs_.end())
+    {
+        outInfo = it->second.info_;
+        if (outInfo.state_ == jobState::running)
+        {
+            outInfo.progress_ = it->second.control_->progress();
+        }
+        return true;
+    }
+    return false;
+}
+
+bool jobManager::cancelJob(const std::string& jobId)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = jobs_.find(jobId);
+    if (it == jobs_.end())
+    {
+        return false;
+    }
+
+    jobRecord& record = it->second;
+    if (record.info_.state_ == jobState::queued)
+    {
+        queue_.erase(std::find(queue_.begin(), queue_.end(), jobId));
+        finishJob(record, jobState::cancelled, {{"success", false}, {"error", "Job cancelled"}});
+        return true;
+    }
+    if (record.info_.state_ == jobState::running)
+    {
+        record.control_->cancel();
+        return true;
+    }
+    return false;
+}
+
+size_t jobManager::queuedJobs() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+size_t jobManager::runningJobs() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_;
+}
+
+jobManager::footprint jobManager::measureMemory() const
+{
+    footprint result;
+    std::lock_guard<std::mutex> lock(mutex_);
+    result.jobs_ = jobs_.size();
+    result.bytes_ = memoryFootprint::treeNodes(jobs_) + (queue_.size() + finished_.size()) * sizeof(std::string);
+    for (const std::deque<std::string>* ids : {&queue_, &finished_})
+    {
+        for (const auto& id : *ids)
+        {
+            result.bytes_ += memoryFootprint::stringBytes(id);
+        }
+    }
+    for (const auto& entry : jobs_)
+    {
+        const jobRecord& record = entry.second;
+        size_t resultBytes = memoryFootprint::jsonBytes(record.info_.result_);
+        result.resultBytes_ += resultBytes;
+        result.bytes_ += resultBytes + memoryFootprint::stringBytes(entry.first) +
+                         memoryFootprint::stringBytes(record.info_.id_) +
+                         memoryFootprint::stringBytes(record.info_.kind_);
+        if (record.control_)
+        {
+            result.bytes_ += memoryFootprint::kSharedControlBytes + sizeof(jobControl);
+        }
+    }
+    return result;
+}
+
+std::string jobManager::stateToString(jobState state)
+{
+    switch (state)
+    {
+        case jobState::queued:
+            return "queued";
+        case jobState::running:
+            return "running";
+        case jobState::completed:
+            return "completed";
+        case jobState::failed:
+            return "failed";
+        case jobState::cancelled:
+            return "cancelled";
+    }
+    return "unknown";
+}
+
+void jobManager::workerLoop()
+{
+    traceRecorder::setThreadName("job worker");
+    while (true)
+    {
+        std::string id;
+        jobWork work;
+        std::shared_ptr<jobControl> control;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            // Drain queued jobs before exiting so accepted saves are not lost
+            if (queue_.empty())
+            {
+                return;
+            }
+            id = std::move(queue_.front());
+            queue_.pop_front();
+            jobRecord& record = jobs_[id];
+            record.info_.state_ = jobState::running;
+            ++running_;
+            work = std::move(record.work_);
+            control = record.control_;
+        }
+
+        nlohmann::json result;
+        try
+        {
+            result = work(*control);
+        }
+        catch (const std::exception& e)
+        {
+            result = {{"success", false}, {"error", e.what()}};
+        }
+
+        bool success = result.value("success", false);
+        jobState state = success ? jobState::completed
+                                 : (control->cancelled() ? jobState::cancelled : jobState::failed);
+        std::lock_guard<std::mutex> lock(mutex_);
+        --running_;
+        finishJob(jobs_[id], state, std::move(result));
+    }
+}
+
+void jobManager::finishJob(jobRecord& record, jobState state, nlohmann::json result)
+{
+    record.info_.state_ = state;
+    record.info_.result_ = std::move(result);
+    if (state == jobState::completed)
+    {
+        record.info_.progress_ = 1.0;
+    }
+    else
+    {
+        record.info_.progress_ = record.control_->progress();
+    }
+    record.work_ = nullptr;
+
+    finished_.push_back(record.info_.id_);
+    while (finished_.size() > kMaxFinishedJobs)
+    {
+        jobs_.erase(finished_.front());
+        finished_.pop_front();
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+// Background job executor - long operations are queued here, run on dedicated threads and polled by job ID
+class jobManager
+{
+  public:
+    enum class jobState
+    {
+        queued,
+        running,
+        completed,
+        failed,
+        cancelled
+    };
+
+    struct jobInfo
+    {
+        std::string id_;
+        std::string kind_;
+        jobState state_;
+        double progress_;        // 0 to 1, as reported by the job
+        nlohmann::json result_;  // Same response the synchronous command would have returned
+    };
+
+    // Handed to running work; cancellation is cooperative, so work polls cancelled() between steps
+    class jobControl
+    {
+      public:
+        jobControl();
+
+        void setProgress(double progress);
+        double progress() const;
+        bool cancelled() const;
+        void cancel();
+
+      private:
+        std::atomic<double> progress_;
+        std::atomic<bool> cancelled_;
+    };
+
+    using jobWork = std::function<nlohmann::json(jobControl&)>;
+
+    // Estimated heap held by job records, mostly the results kept for polling
+    struct footprint
+    {
+        size_t jobs_ = 0;
+        size_t resultBytes_ = 0;
+        size_t bytes_ = 0;  // Records and queues, results included
+    };
+
+    explicit jobManager(size_t threads = kDefaultThreads);
+    ~jobManager();
+
+    // Queue work for the executor; the returned ID is valid immediately
+    std::string submit(const std::string& kind, jobWork work);
+    bool getJob(const std::string& jobId, jobInfo& outInfo) const;
+
+    // Queued jobs are dropped at once; running jobs are asked to stop. False for unknown or finished jobs.
+    bool cancelJob(const std::string& jobId);
+
+    // Jobs waiting for a worker and jobs being worked on
+    size_t queuedJobs() const;
+    size_t runningJobs() const;
+
+    footprint measureMemory() const;
+
+    static std::string stateToString(jobState state);
+
+  private:
+    static constexpr size_t kDefaultThreads = 2;
+    static constexpr size_t kMaxFinishedJobs = 1024;  // Oldest finished jobs are forgotten beyond this
+
+    struct jobRecord
+    {
+        jobInfo info_;
+        std::shared_ptr<jobControl> control_;
+        jobWork work_;
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::string> queue_;
+    std::map<std::string, jobRecord> jobs_;
+    std::deque<std::string> finished_;
+    size_t nextJobId_;
+    size_t running_;
+    bool stopping_;
+    std::vector<std::thread> workers_;
+
+    void workerLoop();
+    void finishJob(jobRecord& record, jobState state, nlohmann::json result);  // Caller must hold mutex_
+};
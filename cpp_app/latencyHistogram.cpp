@@ -0,0 +1,109 @@
+#include "latencyHistogram.hpp"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+int highestBit(uint64_t value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+}  // namespace
+
+latencyHistogram::latencyHistogram()
+{
+    reset();
+}
+
+void latencyHistogram::record(uint64_t nanoseconds)
+{
+    counts_[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    totalNanos_.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+    // Only a new maximum pays for the compare-exchange
+    uint64_t max = maxNanos_.load(std::memory_order_relaxed);
+    while (nanoseconds > max && !maxNanos_.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed))
+    {
+    }
+}
+
+latencyHistogram::summary latencyHistogram::summarize() const
+{
+    std::array<uint64_t, kBuckets> counts;
+    uint64_t count = 0;
+    for (size_t i = 0; i < kBuckets; ++i)
+    {
+        counts[i] = counts_[i].load(std::memory_order_relaxed);
+        count += counts[i];
+    }
+
+    summary result;
+    result.count_ = count;
+    if (count == 0)
+    {
+        return result;
+    }
+
+    uint64_t max = maxNanos_.load(std::memory_order_relaxed);
+    result.meanMicros_ = totalNanos_.load(std::memory_order_relaxed) / 1000.0 / count;
+    result.maxMicros_ = max / 1000.0;
+
+    // Each percentile is the upper bound of the bucket holding that rank, capped at the true maximum
+    const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    double* outputs[] = {&result.p50Micros_, &result.p90Micros_, &result.p99Micros_, &result.p999Micros_};
+    size_t bucket = 0;
+    uint64_t seen = 0;
+    for (int q = 0; q < 4; ++q)
+    {
+        uint64_t rank = static_cast<uint64_t>(quantiles[q] * count);
+        rank = rank < 1 ? 1 : rank;
+        while (bucket < kBuckets && seen + counts[bucket] < rank)
+        {
+            seen += counts[bucket++];
+        }
+        uint64_t value = bucket < kBuckets ? bucketUpperBound(bucket) : max;
+        *outputs[q] = (value < max ? value : max) / 1000.0;
+    }
+    return result;
+}
+
+void latencyHistogram::reset()
+{
+    for (auto& count : counts_)
+    {
+        count.store(0, std::memory_order_relaxed);
+    }
+    totalNanos_.store(0, std::memory_order_relaxed);
+    maxNanos_.store(0, std::memory_order_relaxed);
+}
+
+size_t latencyHistogram::bucketOf(uint64_t nanoseconds)
+{
+    // Values below kSubBuckets get exact buckets; above, the top kSubBucketBits + 1 bits pick the bucket
+    if (nanoseconds < kSubBuckets)
+    {
+        return static_cast<size_t>(nanoseconds);
+    }
+    int shift = highestBit(nanoseconds) - kSubBucketBits;
+    uint64_t subBucket = (nanoseconds >> shift) - kSubBuckets;
+    return static_cast<size_t>(kSubBuckets * (shift + 1) + subBucket);
+}
+
+uint64_t latencyHistogram::bucketUpperBound(size_t bucket)
+{
+    if (bucket < kSubBuckets)
+    {
+        return bucket;
+    }
+    int shift = static_cast<int>(bucket / kSubBuckets) - 1;
+    uint64_t subBucket = bucket % kSubBuckets + kSubBuckets;
+    return ((subBucket + 1) << shift) - 1;
+}
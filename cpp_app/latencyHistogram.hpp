@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Lock-free log-linear latency histogram in the style of HdrHistogram: each power-of-two range of
+// nanoseconds is split into kSubBuckets linear buckets, so percentiles are within ~3% of the true value.
+// Recording is a bucket computation and two relaxed atomic adds, cheap enough to leave on.
+class latencyHistogram
+{
+  public:
+    struct summary
+    {
+        uint64_t count_ = 0;
+        double meanMicros_ = 0.0;
+        double p50Micros_ = 0.0;
+        double p90Micros_ = 0.0;
+        double p99Micros_ = 0.0;
+        double p999Micros_ = 0.0;
+        double maxMicros_ = 0.0;
+    };
+
+    latencyHistogram();
+
+    void record(uint64_t nanoseconds);
+
+    // Concurrent records may land on either side of a summary or reset; neither blocks them
+    summary summarize() const;
+    void reset();
+
+  private:
+    static constexpr int kSubBucketBits = 5;
+    static constexpr uint64_t kSubBuckets = 1ull << kSubBucketBits;
+    static constexpr int kOctaves = 64 - kSubBucketBits;
+    static constexpr size_t kBuckets = kSubBuckets * (kOctaves + 1);
+
+    std::array<std::atomic<uint64_t>, kBuckets> counts_;
+    std::atomic<uint64_t> totalNanos_;
+    std::atomic<uint64_t> maxNanos_;
+
+    static size_t bucketOf(uint64_t nanoseconds);
+    static uint64_t bucketUpperBound(size_t bucket);
+};
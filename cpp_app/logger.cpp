@@ -0,0 +1,369 @@
+#include "logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace
+{
+const char* levelName(logger::level which)
+{
+    switch (which)
+    {
+        case logger::level::debug:
+            return "DEBUG";
+        case logger::level::info:
+            return "INFO";
+        case logger::level::warn:
+            return "WARN";
+        case logger::level::error:
+            return "ERROR";
+    }
+    return "?";
+}
+
+uint64_t unixNanoseconds()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::system_clock::now().time_since_epoch())
+                                     .count());
+}
+}  // namespace
+
+std::atomic<int> logger::minimum_(static_cast<int>(logger::level::info));
+
+logger::field::field(const char* key, double value) : key_(key), kind_(kind::real), real_(value)
+{
+}
+
+logger::field::field(const char* key, const char* value) : key_(key), kind_(kind::text), count_(0)
+{
+    std::strncpy(text_, value ? value : "", kMaxText - 1);
+    text_[kMaxText - 1] = '\0';
+}
+
+logger::field::field(const char* key, const std::string& value) : field(key, value.c_str())
+{
+}
+
+void logger::field::appendTo(std::string& out) const
+{
+    out += ' ';
+    out += key_;
+    out += '=';
+    switch (kind_)
+    {
+        case kind::integer:
+            out += std::to_string(integer_);
+            break;
+        case kind::count:
+            out += std::to_string(count_);
+            break;
+        case kind::real:
+        {
+            char number[32];
+            std::snprintf(number, sizeof(number), "%g", real_);
+            out += number;
+            break;
+        }
+        case kind::text:
+            // Quoted when it would not read back as one token
+            if (text_[0] == '\0' || std::strpbrk(text_, " \"="))
+            {
+                out += '"';
+                for (const char* c = text_; *c; ++c)
+                {
+                    if (*c == '"' || *c == '\\')
+                    {
+                        out += '\\';
+                    }
+                    out += *c;
+                }
+                out += '"';
+            }
+            else
+            {
+                out += text_;
+            }
+            break;
+    }
+}
+
+logger::logger() : rateLimit_(100), buffers_(nullptr)
+{
+    writer_ = std::thread(&logger::writerLoop, this);
+}
+
+logger& logger::instance()
+{
+    // Never destroyed, so threads exiting at shutdown can still log; pending records are written at exit
+    static logger* instance = []()
+    {
+        logger* created = new logger();
+        std::atexit([]() { logger::instance().flush(); });
+        return created;
+    }();
+    return *instance;
+}
+
+void logger::setLevel(level minimum)
+{
+    minimum_.store(static_cast<int>(minimum), std::memory_order_relaxed);
+}
+
+void logger::setRateLimit(uint32_t perMessagePerSecond)
+{
+    rateLimit_.store(perMessagePerSecond, std::memory_order_relaxed);
+}
+
+bool logger::parseLevel(const std::string& name, level& outLevel)
+{
+    const std::pair<const char*, level> levels[] = {
+        {"debug", level::debug}, {"info", level::info}, {"warn", level::warn}, {"error", level::error}};
+    for (const auto& entry : levels)
+    {
+        if (name == entry.first)
+        {
+            outLevel = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+void logger::log(level which, const char* component, const char* message, std::initializer_list<field> fields)
+{
+    if (!enabled(which))
+    {
+        return;
+    }
+    uint32_t suppressed = 0;
+    if (!admit(message, suppressed))
+    {
+        return;
+    }
+    threadBuffer* buffer = localBuffer();
+    uint64_t head = buffer->head_.load(std::memory_order_relaxed);
+    if (head - buffer->tail_.load(std::memory_order_acquire) >= kRecordsPerThread)
+    {
+        buffer->dropped_.fetch_add(1 + suppressed, std::memory_order_relaxed);
+        return;  // The writer is behind; dropping beats waiting for it
+    }
+
+    record& entry = buffer->records_[head % kRecordsPerThread];
+    entry.unixNanoseconds_ = unixNanoseconds();
+    entry.level_ = which;
+    entry.component_ = component;
+    entry.message_ = message;
+    entry.suppressed_ = suppressed;
+    entry.fieldCount_ = 0;
+    for (const field& f : fields)
+    {
+        if (entry.fieldCount_ == kMaxFields)
+        {
+            break;
+        }
+        entry.fields_[entry.fieldCount_++] = f;
+    }
+    buffer->head_.store(head + 1, std::memory_order_release);
+}
+
+void logger::debug(const char* component, const char* message, std::initializer_list<field> fields)
+{
+    if (enabled(level::debug))
+    {
+        instance().log(level::debug, component, message, fields);
+    }
+}
+
+void logger::info(const char* component, const char* message, std::initializer_list<field> fields)
+{
+    if (enabled(level::info))
+    {
+        instance().log(level::info, component, message, fields);
+    }
+}
+
+void logger::warn(const char* component, const char* message, std::initializer_list<field> fields)
+{
+    if (enabled(level::warn))
+    {
+        instance().log(level::warn, component, message, fields);
+    }
+}
+
+void logger::error(const char* component, const char* message, std::initializer_list<field> fields)
+{
+    if (enabled(level::error))
+    {
+        instance().log(level::error, component, message, fields);
+    }
+}
+
+void logger::flush()
+{
+    drain();
+}
+
+logger::threadBuffer* logger::localBuffer()
+{
+    thread_local threadHandle local;
+    if (!local.buffer_)
+    {
+        local.buffer_ = new threadBuffer();
+        threadBuffer* head = buffers_.load(std::memory_order_relaxed);
+        do
+        {
+            local.buffer_->next_ = head;
+        } while (!buffers_.compare_exchange_weak(head, local.buffer_, std::memory_order_release,
+                                                 std::memory_order_relaxed));
+    }
+    return local.buffer_;
+}
+
+bool logger::admit(const char* message, uint32_t& outSuppressed)
+{
+    uint32_t limit = rateLimit_.load(std::memory_order_relaxed);
+    if (limit == 0)
+    {
+        return true;
+    }
+    rateSlot& slot = rateSlots_[(reinterpret_cast<uintptr_t>(message) >> 3) % kRateSlots];
+    uint64_t second = unixNanoseconds() / 1000000000ull;
+    uint64_t current = slot.second_.load(std::memory_order_relaxed);
+    if (current != second && slot.second_.compare_exchange_strong(current, second, std::memory_order_relaxed))
+    {
+        slot.used_.store(0, std::memory_order_relaxed);  // First record of a new second opens a new budget
+    }
+    if (slot.used_.fetch_add(1, std::memory_order_relaxed) >= limit)
+    {
+        slot.suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    outSuppressed = slot.suppressed_.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+void logger::writerLoop()
+{
+    // Polled rather than signalled, so logging threads never touch a lock or a futex
+    while (true)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        drain();
+    }
+}
+
+void logger::drain()
+{
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    std::vector<std::pair<uint64_t, std::pair<level, std::string>>> lines;
+
+    threadBuffer* previous = nullptr;
+    threadBuffer* buffer = buffers_.load(std::memory_order_acquire);
+    while (buffer)
+    {
+        bool retired = buffer->retired_.load(std::memory_order_acquire);
+        uint64_t tail = buffer->tail_.load(std::memory_order_relaxed);
+        uint64_t head = buffer->head_.load(std::memory_order_acquire);
+        for (; tail < head; ++tail)
+        {
+            const record& entry = buffer->records_[tail % kRecordsPerThread];
+            lines.emplace_back(entry.unixNanoseconds_, std::make_pair(entry.level_, format(entry)));
+        }
+        buffer->tail_.store(tail, std::memory_order_release);
+        uint64_t dropped = buffer->dropped_.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0)
+        {
+            record notice{unixNanoseconds(), level::warn, "logger", "Records dropped, ring buffer full", 0, 1, {}};
+            notice.fields_[0] = field("dropped", dropped);
+            lines.emplace_back(notice.unixNanoseconds_, std::make_pair(notice.level_, format(notice)));
+        }
+
+        threadBuffer* next = buffer->next_;
+        if (retired)
+        {
+            // Its thread has exited and everything it wrote is drained. Logging threads only ever change
+            // the list head, so an inner node can be unlinked directly and the head with a CAS.
+            threadBuffer* expected = buffer;
+            if (previous)
+            {
+                previous->next_ = next;
+                delete buffer;
+            }
+            else if (buffers_.compare_exchange_strong(expected, next, std::memory_order_acq_rel))
+            {
+                delete buffer;
+            }
+            else
+            {
+                previous = buffer;  // A thread pushed in front of it; unlinked on a later pass
+            }
+        }
+        else
+        {
+            previous = buffer;
+        }
+        buffer = next;
+    }
+
+    // Threads drain in list order; sorting puts their records back in time order
+    std::stable_sort(lines.begin(), lines.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    bool wroteOut = false;
+    bool wroteErr = false;
+    for (const auto& line : lines)
+    {
+        bool toErr = line.second.first >= level::warn;
+        (toErr ? std::cerr : std::cout) << line.second.second << '\n';
+        (toErr ? wroteErr : wroteOut) = true;
+    }
+    if (wroteOut)
+    {
+        std::cout.flush();
+    }
+    if (wroteErr)
+    {
+        std::cerr.flush();
+    }
+}
+
+std::string logger::format(const record& entry)
+{
+    std::time_t seconds = static_cast<std::time_t>(entry.unixNanoseconds_ / 1000000000ull);
+    std::tm utc{};
+#ifdef _WIN32
+    gmtime_s(&utc, &seconds);
+#else
+    gmtime_r(&seconds, &utc);
+#endif
+    char time[32];
+    std::strftime(time, sizeof(time), "%Y-%m-%dT%H:%M:%S", &utc);
+    char millis[8];
+    std::snprintf(millis, sizeof(millis), ".%03uZ", static_cast<unsigned>(entry.unixNanoseconds_ / 1000000 % 1000));
+
+    std::string line = std::string(time) + millis + ' ' + levelName(entry.level_) + ' ' + entry.component_ + ": " +
+                       entry.message_;
+    for (uint8_t i = 0; i < entry.fieldCount_; ++i)
+    {
+        entry.fields_[i].appendTo(line);
+    }
+    if (entry.suppressed_ > 0)
+    {
+        line += " suppressed=" + std::to_string(entry.suppressed_);
+    }
+    return line;
+}
+
+logger::threadHandle::~threadHandle()
+{
+    if (buffer_)
+    {
+        buffer_->retired_.store(true, std::memory_order_release);
+    }
+}
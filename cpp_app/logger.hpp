@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+// Process-wide structured logger. A record is a level, a component, a message and a few key=value fields;
+// numbers are stored raw and everything is formatted later on a background thread that drains per-thread
+// ring buffers. Logging never blocks: a full ring or a message over its rate limit drops the record and
+// counts it. Components, messages and field keys must be string literals; field text values are copied.
+class logger
+{
+  public:
+    enum class level
+    {
+        debug,
+        info,
+        warn,
+        error
+    };
+
+    static constexpr size_t kRecordsPerThread = 128;
+    static constexpr size_t kMaxFields = 4;
+    static constexpr size_t kMaxText = 64;  // Longer text values are truncated
+
+    class field
+    {
+      public:
+        field() : key_(nullptr), kind_(kind::count), count_(0), text_{}
+        {
+        }
+        template <typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+        field(const char* key, T value) : key_(key), kind_(std::is_signed<T>::value ? kind::integer : kind::count)
+        {
+            if (std::is_signed<T>::value)
+            {
+                integer_ = static_cast<int64_t>(value);
+            }
+            else
+            {
+                count_ = static_cast<uint64_t>(value);
+            }
+        }
+        field(const char* key, double value);
+        field(const char* key, const char* value);
+        field(const char* key, const std::string& value);
+
+        void appendTo(std::string& out) const;
+
+      private:
+        enum class kind : uint8_t
+        {
+            integer,
+            count,
+            real,
+            text
+        };
+
+        const char* key_;
+        kind kind_;
+        union
+        {
+            int64_t integer_;
+            uint64_t count_;
+            double real_;
+        };
+        char text_[kMaxText];
+    };
+
+    static logger& instance();
+
+    // Startup configuration
+    void setLevel(level minimum);
+    void setRateLimit(uint32_t perMessagePerSecond);  // 0 disables the limit
+    static bool parseLevel(const std::string& name, level& outLevel);
+
+    static bool enabled(level which)
+    {
+        return static_cast<int>(which) >= minimum_.load(std::memory_order_relaxed);
+    }
+
+    void log(level which, const char* component, const char* message, std::initializer_list<field> fields = {});
+
+    static void debug(const char* component, const char* message, std::initializer_list<field> fields = {});
+    static void info(const char* component, const char* message, std::initializer_list<field> fields = {});
+    static void warn(const char* component, const char* message, std::initializer_list<field> fields = {});
+    static void error(const char* component, const char* message, std::initializer_list<field> fields = {});
+
+    // Writes everything logged so far; used at exit
+    void flush();
+
+  private:
+    struct record
+    {
+        uint64_t unixNanoseconds_;
+        level level_;
+        const char* component_;
+        const char* message_;
+        uint32_t suppressed_;  // Earlier records of this message dropped by the rate limit
+        uint8_t fieldCount_;
+        field fields_[kMaxFields];
+    };
+
+    // Single-producer ring owned by one thread, drained by the writer thread; linked into a list that
+    // threads push onto with a CAS and only the writer unlinks from
+    struct threadBuffer
+    {
+        std::array<record, kRecordsPerThread> records_;
+        std::atomic<uint64_t> head_{0};
+        std::atomic<uint64_t> tail_{0};
+        std::atomic<uint64_t> dropped_{0};
+        std::atomic<bool> retired_{false};
+        threadBuffer* next_ = nullptr;
+    };
+
+    struct threadHandle
+    {
+        threadBuffer* buffer_ = nullptr;
+        ~threadHandle();
+    };
+
+    // Per-message budget for the current second, found by hashing the message pointer
+    struct rateSlot
+    {
+        std::atomic<uint64_t> second_{0};
+        std::atomic<uint32_t> used_{0};
+        std::atomic<uint32_t> suppressed_{0};
+    };
+    static constexpr size_t kRateSlots = 64;
+
+    static std::atomic<int> minimum_;
+    std::atomic<uint32_t> rateLimit_;
+    std::array<rateSlot, kRateSlots> rateSlots_;
+    std::atomic<threadBuffer*> buffers_;
+    std::mutex writerMutex_;  // Held by the writer and flush(); never by logging threads
+    std::thread writer_;
+
+    logger();
+    threadBuffer* localBuffer();
+    bool admit(const char* message, uint32_t& outSuppressed);
+    void writerLoop();
+    void drain();
+    static std::string format(const record& entry);
+};
@@ -0,0 +1,206 @@
+#include "lzBlockCodec.hpp"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+constexpr size_t kMinMatch = 4;
+constexpr size_t kLastLiterals = 5;  // The format requires the block to end in literals
+constexpr size_t kMatchSearchLimit = 12;
+constexpr size_t kMaxOffset = 65535;
+constexpr int kHashLog = 16;
+
+uint32_t read32(const char* p)
+{
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint32_t hashSequence(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - kHashLog);
+}
+
+// Length fields overflow from the token nibble into 255-valued continuation bytes
+char* writeLength(char* op, size_t length)
+{
+    while (length >= 255)
+    {
+        *op++ = static_cast<char>(255);
+        length -= 255;
+    }
+    *op++ = static_cast<char>(length);
+    return op;
+}
+
+char* writeSequence(char* op, const char* literals, size_t literalLength, size_t offset, size_t matchLength)
+{
+    char* token = op++;
+    uint8_t tokenValue = 0;
+    if (literalLength >= 15)
+    {
+        tokenValue = 15 << 4;
+        op = writeLength(op, literalLength - 15);
+    }
+    else
+    {
+        tokenValue = static_cast<uint8_t>(literalLength << 4);
+    }
+    std::memcpy(op, literals, literalLength);
+    op += literalLength;
+
+    if (matchLength > 0)
+    {
+        *op++ = static_cast<char>(offset & 0xff);
+        *op++ = static_cast<char>(offset >> 8);
+        size_t encodedMatch = matchLength - kMinMatch;
+        if (encodedMatch >= 15)
+        {
+            tokenValue |= 15;
+            op = writeLength(op, encodedMatch - 15);
+        }
+        else
+        {
+            tokenValue |= static_cast<uint8_t>(encodedMatch);
+        }
+    }
+    *token = static_cast<char>(tokenValue);
+    return op;
+}
+
+bool readLength(const uint8_t*& ip, const uint8_t* end, size_t& length)
+{
+    uint8_t byte;
+    do
+    {
+        if (ip >= end)
+        {
+            return false;
+        }
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+}  // namespace
+
+size_t lzBlockCodec::maxCompressedSize(size_t inputSize)
+{
+    return inputSize + inputSize / 255 + 16;
+}
+
+size_t lzBlockCodec::compress(const char* src, size_t srcSize, char* dst, size_t dstCapacity)
+{
+    if (dstCapacity < maxCompressedSize(srcSize))
+    {
+        return 0;
+    }
+
+    char* op = dst;
+    size_t anchor = 0;
+    if (srcSize > kMatchSearchLimit)
+    {
+        std::vector<uint32_t> table(size_t(1) << kHashLog, 0);
+        const size_t matchLimit = srcSize - kLastLiterals;
+        const size_t searchLimit = srcSize - kMatchSearchLimit;
+
+        size_t ip = 0;
+        while (ip < searchLimit)
+        {
+            uint32_t sequence = read32(src + ip);
+            uint32_t& slot = table[hashSequence(sequence)];
+            size_t candidate = slot;
+            slot = static_cast<uint32_t>(ip);
+
+            if (candidate >= ip || ip - candidate > kMaxOffset || read32(src + candidate) != sequence)
+            {
+                // Skip faster through data that is not matching
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            size_t matchLength = kMinMatch;
+            while (ip + matchLength < matchLimit && src[candidate + matchLength] == src[ip + matchLength])
+            {
+                ++matchLength;
+            }
+
+            op = writeSequence(op, src + anchor, ip - anchor, ip - candidate, matchLength);
+            ip += matchLength;
+            anchor = ip;
+            if (ip < searchLimit)
+            {
+                table[hashSequence(read32(src + ip - 2))] = static_cast<uint32_t>(ip - 2);
+            }
+        }
+    }
+
+    op = writeSequence(op, src + anchor, srcSize - anchor, 0, 0);
+    return static_cast<size_t>(op - dst);
+}
+
+bool lzBlockCodec::decompress(const char* src, size_t srcSize, char* dst, size_t dstSize)
+{
+    const auto* ip = reinterpret_cast<const uint8_t*>(src);
+    const uint8_t* end = ip + srcSize;
+    size_t op = 0;
+
+    while (ip < end)
+    {
+        uint8_t token = *ip++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(ip, end, literalLength))
+        {
+            return false;
+        }
+        if (literalLength > static_cast<size_t>(end - ip) || literalLength > dstSize - op)
+        {
+            return false;
+        }
+        std::memcpy(dst + op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        if (ip == end)
+        {
+            break;  // The last sequence carries literals only
+        }
+
+        if (end - ip < 2)
+        {
+            return false;
+        }
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(ip, end, matchLength))
+        {
+            return false;
+        }
+        matchLength += kMinMatch;
+        if (offset == 0 || offset > op || matchLength > dstSize - op)
+        {
+            return false;
+        }
+
+        // Matches may overlap their own output (run-length style), so copy forward byte by byte then
+        const char* match = dst + op - offset;
+        if (offset >= matchLength)
+        {
+            std::memcpy(dst + op, match, matchLength);
+        }
+        else
+        {
+            for (size_t i = 0; i < matchLength; ++i)
+            {
+                dst[op + i] = match[i];
+            }
+        }
+        op += matchLength;
+    }
+    return op == dstSize;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+
+// LZ77-family block codec producing the LZ4 block format. Blocks are self-contained,
+// so independent blocks can be compressed and decompressed on separate threads.
+class lzBlockCodec
+{
+  public:
+    static size_t maxCompressedSize(size_t inputSize);
+
+    // Returns the compressed size, or 0 if dst is too small
+    static size_t compress(const char* src, size_t srcSize, char* dst, size_t dstCapacity);
+
+    // dstSize must be the exact decompressed size; malformed input is rejected, never overrun
+    static bool decompress(const char* src, size_t srcSize, char* dst, size_t dstSize);
+};
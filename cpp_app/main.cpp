@@ -1,11 +1,63 @@
+#include <chrono>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
+#include "allocationTracker.hpp"
 #include "grpcServerStrategy.hpp"
+#include "logger.hpp"
+#include "metricsHttpServer.hpp"
+#include "perfCounters.hpp"
+#include "rayPacketKernels.hpp"
+#include "renderCache.hpp"
 #include "socketServerStrategy.hpp"
 
+static int runKernelBenchmark(size_t primitives)
+{
+    const size_t packets = 20000;
+    std::cout << "Ray packet kernels: " << primitives << " primitives, " << packets * rayPacket::kWidth
+              << " rays" << std::endl;
+    for (const auto& result : rayPacketKernels::benchmark(primitives, packets))
+    {
+        std::cout << "  " << rayPacketKernels::levelName(result.level_) << ": "
+                  << static_cast<uint64_t>(result.raysPerSecond_) << " rays/s (" << result.hits_ << " hits)"
+                  << std::endl;
+    }
+    return 0;
+}
+
+static void printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [socket|grpc] [address] [options]" << std::endl;
+    std::cerr << "       " << program << " benchmark [primitives]" << std::endl;
+    std::cerr << "  socket mode: address is port number (default: 9876)" << std::endl;
+    std::cerr << "  grpc mode: address is host:port (default: 0.0.0.0:50051)" << std::endl;
+    std::cerr << "  benchmark mode: reports ray packet throughput per SIMD level and exits" << std::endl;
+    std::cerr << "Options:" << std::endl;
+    std::cerr << "  --wal <path>                     log mutations and recover from <path> on startup" << std::endl;
+    std::cerr << "  --wal-sync <always|interval|none> fsync policy for the log (default: always)" << std::endl;
+    std::cerr << "  --render-cache-mb <n>            memory for cached render images (default: 64)"
+              << std::endl;
+    std::cerr << "  --render-cache-dir <path>        spill images evicted from memory to <path>" << std::endl;
+    std::cerr << "  --render-cache-disk-mb <n>       disk budget for spilled images (default: 1024)" << std::endl;
+    std::cerr << "  --slow-log <path>                append requests slower than --slow-ms to <path>" << std::endl;
+    std::cerr << "  --slow-ms <n>                    slow-request threshold in milliseconds (default: 100)"
+              << std::endl;
+    std::cerr << "  --metrics-port <port>            serve Prometheus metrics at http://<bind>:<port>/metrics"
+              << std::endl;
+    std::cerr << "  --metrics-bind <address>         address for the metrics listener (default: 127.0.0.1)"
+              << std::endl;
+    std::cerr << "  --log-level <debug|info|warn|error> minimum level logged (default: info)" << std::endl;
+    std::cerr << "  --log-rate <n>                   records per message per second, 0 = unlimited (default: 100)"
+              << std::endl;
+    std::cerr << "  --alloc-tracking <on|off>        count heap allocations and bytes per command" << std::endl;
+    std::cerr << "  --perf-counters <on|off>         count cycles, instructions and misses per command (Linux)"
+              << std::endl;
+}
+
 int main(int argc, char** argv)
 {
     try
@@ -13,19 +65,39 @@ int main(int argc, char** argv)
         std::string mode = "socket";  // Default mode
         std::string address;
 
-        // Parse command line arguments
-        if (argc > 1)
+        // Parse command line arguments: positional mode and address, then --option value pairs
+        std::vector<std::string> positional;
+        std::map<std::string, std::string> options;
+        for (int i = 1; i < argc; ++i)
         {
-            mode = argv[1];
+            std::string arg = argv[i];
+            if (arg.rfind("--", 0) == 0 && i + 1 < argc)
+            {
+                options[arg.substr(2)] = argv[++i];
+            }
+            else
+            {
+                positional.push_back(arg);
+            }
+        }
+
+        if (!positional.empty())
+        {
+            mode = positional[0];
+        }
+
+        if (mode == "benchmark")
+        {
+            return runKernelBenchmark(positional.size() > 1 ? std::stoul(positional[1]) : 256);
         }
 
         std::unique_ptr<serverStrategy> server;
         if (mode == "socket")
         {
             int port = 9876;
-            if (argc > 2)
+            if (positional.size() > 1)
             {
-                port = std::stoi(argv[2]);
+                port = std::stoi(positional[1]);
             }
             address = std::to_string(port);
             server = std::make_unique<socketServerStrategy>(port);
@@ -33,17 +105,15 @@ int main(int argc, char** argv)
         else if (mode == "grpc")
         {
             address = "0.0.0.0:50051";
-            if (argc > 2)
+            if (positional.size() > 1)
             {
-                address = argv[2];
+                address = positional[1];
             }
             server = std::make_unique<grpcServerStrategy>(address);
         }
         else
         {
-            std::cerr << "Usage: " << argv[0] << " [socket|grpc] [address]" << std::endl;
-            std::cerr << "  socket mode: address is port number (default: 9876)" << std::endl;
-            std::cerr << "  grpc mode: address is host:port (default: 0.0.0.0:50051)" << std::endl;
+            printUsage(argv[0]);
             return 1;
         }
 
@@ -52,6 +122,99 @@ int main(int argc, char** argv)
         std::cout << "========================================" << std::endl;
         std::cout << "Mode: " << mode << std::endl;
         std::cout << "Address: " << address << std::endl;
+
+        if (options.count("log-level"))
+        {
+            logger::level minimum;
+            if (!logger::parseLevel(options["log-level"], minimum))
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+            logger::instance().setLevel(minimum);
+        }
+        if (options.count("log-rate"))
+        {
+            logger::instance().setRateLimit(static_cast<uint32_t>(std::stoul(options["log-rate"])));
+        }
+        if (options.count("wal"))
+        {
+            writeAheadLog::syncPolicy policy = writeAheadLog::syncPolicy::always;
+            if (options.count("wal-sync") && !writeAheadLog::parsePolicy(options["wal-sync"], policy))
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+
+            size_t replayed = 0;
+            if (!server->getHandler().enableWriteAheadLog(options["wal"], policy, replayed))
+            {
+                throw std::runtime_error("Failed to recover from write-ahead log: " + options["wal"]);
+            }
+            std::cout << "Write-ahead log: " << options["wal"] << " (" << replayed << " records replayed)"
+                      << std::endl;
+        }
+        if (options.count("render-cache-mb") || options.count("render-cache-dir"))
+        {
+            const size_t megabyte = 1024 * 1024;
+            size_t memoryBytes = options.count("render-cache-mb") ? std::stoul(options["render-cache-mb"]) * megabyte
+                                                                  : renderCache::kDefaultMemoryBytes;
+            size_t spillBytes = options.count("render-cache-disk-mb")
+                                    ? std::stoul(options["render-cache-disk-mb"]) * megabyte
+                                    : renderCache::kDefaultSpillBytes;
+            server->getHandler().configureRenderCache(memoryBytes, options["render-cache-dir"], spillBytes);
+            std::cout << "Render cache: " << memoryBytes / megabyte << " MB"
+                      << (options["render-cache-dir"].empty() ? "" : ", spilling to " + options["render-cache-dir"])
+                      << std::endl;
+        }
+        if (options.count("slow-log"))
+        {
+            double thresholdMs = options.count("slow-ms") ? std::stod(options["slow-ms"]) : 100.0;
+            auto threshold = std::chrono::microseconds(static_cast<int64_t>(thresholdMs * 1000));
+            if (!server->getHandler().enableSlowLog(options["slow-log"], threshold))
+            {
+                throw std::runtime_error("Failed to open slow-request log: " + options["slow-log"]);
+            }
+            std::cout << "Slow-request log: " << options["slow-log"] << " (over " << thresholdMs << " ms)"
+                      << std::endl;
+        }
+        if (options.count("alloc-tracking") && options["alloc-tracking"] != "off")
+        {
+            if (options["alloc-tracking"] != "on")
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+            allocationTracker::enable();
+            std::cout << "Allocation tracking: heap allocations and bytes per command" << std::endl;
+        }
+        if (options.count("perf-counters") && options["perf-counters"] != "off")
+        {
+            if (options["perf-counters"] != "on")
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+            std::string error;
+            if (!perfCounters::enable(error))
+            {
+                throw std::runtime_error(error);
+            }
+            std::cout << "Hardware counters: cycles, instructions, cache and branch misses per command" << std::endl;
+        }
+        std::unique_ptr<metricsHttpServer> metrics;
+        if (options.count("metrics-port"))
+        {
+            std::string bind = options.count("metrics-bind") ? options["metrics-bind"] : "127.0.0.1";
+            metrics = std::make_unique<metricsHttpServer>(server->getHandler(), bind,
+                                                          std::stoi(options["metrics-port"]));
+            std::string error;
+            if (!metrics->start(error))
+            {
+                throw std::runtime_error(error);
+            }
+            std::cout << "Metrics: http://" << bind << ":" << options["metrics-port"] << "/metrics" << std::endl;
+        }
         std::cout << "========================================" << std::endl;
 
         // Start the server (this will block)
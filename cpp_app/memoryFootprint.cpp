@@ -0,0 +1,59 @@
+#include "memoryFootprint.hpp"
+
+size_t memoryFootprint::stringBytes(const std::string& value)
+{
+    // Inline storage lies within the object itself; anything else was allocated with capacity + 1 bytes
+    const char* data = value.data();
+    const char* object = reinterpret_cast<const char*>(&value);
+    if (data >= object && data < object + sizeof(std::string))
+    {
+        return 0;
+    }
+    return value.capacity() + 1;
+}
+
+size_t memoryFootprint::jsonBytes(const nlohmann::json& value)
+{
+    switch (value.type())
+    {
+        case nlohmann::json::value_t::object:
+        {
+            const auto& members = value.get_ref<const nlohmann::json::object_t&>();
+            size_t bytes = sizeof(nlohmann::json::object_t) + treeNodes(members);
+            for (const auto& member : members)
+            {
+                bytes += stringBytes(member.first) + jsonBytes(member.second);
+            }
+            return bytes;
+        }
+        case nlohmann::json::value_t::array:
+        {
+            const auto& elements = value.get_ref<const nlohmann::json::array_t&>();
+            size_t bytes = sizeof(nlohmann::json::array_t) + vectorBytes(elements);
+            for (const auto& element : elements)
+            {
+                bytes += jsonBytes(element);
+            }
+            return bytes;
+        }
+        case nlohmann::json::value_t::string:
+        {
+            const auto& text = value.get_ref<const nlohmann::json::string_t&>();
+            return sizeof(nlohmann::json::string_t) + stringBytes(text);
+        }
+        case nlohmann::json::value_t::binary:
+            return sizeof(nlohmann::json::binary_t) + vectorBytes(value.get_binary());
+        default:
+            return 0;  // Numbers, booleans and null live inside the value
+    }
+}
+
+size_t memoryFootprint::stringSet(const std::set<std::string>& values)
+{
+    size_t bytes = treeNodes(values);
+    for (const auto& value : values)
+    {
+        bytes += stringBytes(value);
+    }
+    return bytes;
+}
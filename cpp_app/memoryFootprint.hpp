@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+// Heap bytes behind standard containers, estimated from their sizes and capacities rather than asked of the
+// allocator, so a report is deterministic for a given scene. Node layouts follow libstdc++ and libc++;
+// per-allocation allocator headers and rounding are not counted. None of these include sizeof the container.
+class memoryFootprint
+{
+  public:
+    static constexpr size_t kTreeNodeOverhead = 4 * sizeof(void*);  // Color, parent and two children
+    static constexpr size_t kListNodeOverhead = 2 * sizeof(void*);
+    static constexpr size_t kHashNodeOverhead = sizeof(void*) + sizeof(size_t);  // Next link and cached hash
+    static constexpr size_t kSharedControlBytes = 2 * sizeof(void*);  // make_shared: vtable and two counts
+
+    // Zero while the characters fit in the small-string buffer inside the object
+    static size_t stringBytes(const std::string& value);
+
+    // Heap behind a JSON value, including its strings and nested values
+    static size_t jsonBytes(const nlohmann::json& value);
+
+    template <typename T>
+    static size_t vectorBytes(const std::vector<T>& values)
+    {
+        return values.capacity() * sizeof(T);
+    }
+
+    // Nodes only; heap owned by the keys and values is the caller's to add
+    template <typename K, typename V, typename C, typename A>
+    static size_t treeNodes(const std::map<K, V, C, A>& values)
+    {
+        return values.size() * (kTreeNodeOverhead + sizeof(typename std::map<K, V, C, A>::value_type));
+    }
+
+    template <typename K, typename C, typename A>
+    static size_t treeNodes(const std::set<K, C, A>& values)
+    {
+        return values.size() * (kTreeNodeOverhead + sizeof(K));
+    }
+
+    template <typename K, typename V, typename H, typename E, typename A>
+    static size_t hashNodes(const std::unordered_map<K, V, H, E, A>& values)
+    {
+        using valueType = typename std::unordered_map<K, V, H, E, A>::value_type;
+        return values.size() * (kHashNodeOverhead + sizeof(valueType)) + values.bucket_count() * sizeof(void*);
+    }
+
+    template <typename T, typename A>
+    static size_t listNodes(const std::list<T, A>& values)
+    {
+        return values.size() * (kListNodeOverhead + sizeof(T));
+    }
+
+    // A set of strings: nodes plus the strings' own buffers
+    static size_t stringSet(const std::set<std::string>& values);
+};
@@ -0,0 +1,344 @@
+#include "metricsHttpServer.hpp"
+#include <sstream>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define INVALID_SOCKET -1
+#define SOCKET_ERROR -1
+#define closesocket close
+#endif
+
+namespace
+{
+constexpr size_t kMaxRequestBytes = 8192;
+// Per direction for the whole exchange, not per call, so a client trickling bytes cannot stretch it
+constexpr std::chrono::milliseconds kExchangeTimeout(2000);
+
+// A scraper that hangs up mid-response must fail the send, not raise SIGPIPE and end the process
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0;
+#endif
+
+// One metric family: HELP and TYPE lines followed by its samples
+void family(std::ostringstream& out, const char* name, const char* type, const char* help)
+{
+    out << "# HELP " << name << ' ' << help << '\n' << "# TYPE " << name << ' ' << type << '\n';
+}
+}  // namespace
+
+metricsHttpServer::metricsHttpServer(commandHandler& handler, const std::string& bindAddress, int port)
+    : handler_(handler), bindAddress_(bindAddress), port_(port), running_(false), listenSocket_(INVALID_SOCKET)
+{
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+}
+
+metricsHttpServer::~metricsHttpServer()
+{
+    if (running_.exchange(false))
+    {
+        // Unblocks accept() so the serving thread can see running_ and exit
+#ifdef _WIN32
+        closesocket(listenSocket_);
+#else
+        shutdown(listenSocket_, SHUT_RDWR);
+#endif
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+#ifndef _WIN32
+        closesocket(listenSocket_);
+#endif
+    }
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool metricsHttpServer::start(std::string& outError)
+{
+    listenSocket_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenSocket_ == INVALID_SOCKET)
+    {
+        outError = "Failed to create metrics socket";
+        return false;
+    }
+
+    int opt = 1;
+    setsockopt(listenSocket_, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&opt), sizeof(opt));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port_));
+    if (inet_pton(AF_INET, bindAddress_.c_str(), &address.sin_addr) != 1)
+    {
+        closesocket(listenSocket_);
+        outError = "Invalid metrics bind address: " + bindAddress_;
+        return false;
+    }
+    if (bind(listenSocket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == SOCKET_ERROR ||
+        listen(listenSocket_, 16) == SOCKET_ERROR)
+    {
+        closesocket(listenSocket_);
+        outError = "Failed to listen for metrics on " + bindAddress_ + ":" + std::to_string(port_);
+        return false;
+    }
+
+    running_ = true;
+    thread_ = std::thread(&metricsHttpServer::serveLoop, this);
+    return true;
+}
+
+std::string metricsHttpServer::render()
+{
+    nlohmann::json status = handler_.getSoftwareStatus(nlohmann::json::object());
+    std::ostringstream out;
+
+    family(out, "cpp_app_uptime_seconds", "gauge", "Seconds since the process started.");
+    out << "cpp_app_uptime_seconds " << status["uptime_seconds"].get<double>() << '\n';
+
+    family(out, "cpp_app_requests_total", "counter", "Requests received, by transport.");
+    out << "cpp_app_requests_total{transport=\"socket\"} " << status["socket_requests"].get<uint64_t>() << '\n';
+    out << "cpp_app_requests_total{transport=\"grpc\"} " << status["grpc_requests"].get<uint64_t>() << '\n';
+
+    family(out, "cpp_app_failed_requests_total", "counter", "Requests that returned an error.");
+    out << "cpp_app_failed_requests_total " << status["failed_requests"].get<uint64_t>() << '\n';
+
+    family(out, "cpp_app_connections_accepted_total", "counter", "Socket connections accepted.");
+    out << "cpp_app_connections_accepted_total " << status["connections_accepted"].get<uint64_t>() << '\n';
+
+    family(out, "cpp_app_active_connections", "gauge", "Socket clients currently connected.");
+    out << "cpp_app_active_connections " << status["active_connections"].get<int64_t>() << '\n';
+
+    family(out, "cpp_app_objects", "gauge", "Objects in the scene.");
+    out << "cpp_app_objects " << status["object_count"].get<uint64_t>() << '\n';
+
+    family(out, "cpp_app_resident_memory_bytes", "gauge", "Resident set size.");
+    out << "cpp_app_resident_memory_bytes " << status["rss_bytes"].get<uint64_t>() << '\n';
+
+    family(out, "cpp_app_peak_resident_memory_bytes", "gauge", "Peak resident set size.");
+    out << "cpp_app_peak_resident_memory_bytes " << status["peak_rss_bytes"].get<uint64_t>() << '\n';
+
+    family(out, "cpp_app_heap_bytes", "gauge", "Data segment size: heap plus private anonymous mappings.");
+    out << "cpp_app_heap_bytes " << status["heap_bytes"].get<uint64_t>() << '\n';
+
+    family(out, "cpp_app_jobs_queued", "gauge", "Background jobs waiting for a worker.");
+    out << "cpp_app_jobs_queued " << status["jobs_queued"].get<uint64_t>() << '\n';
+
+    family(out, "cpp_app_jobs_running", "gauge", "Background jobs being worked on.");
+    out << "cpp_app_jobs_running " << status["jobs_running"].get<uint64_t>() << '\n';
+
+    // Summaries, since the histograms' fine buckets would make thousands of series
+    family(out, "cpp_app_request_duration_seconds", "summary", "Request latency by transport and command.");
+    handler_.metrics().forEachCommand(
+        [&](runtimeMetrics::transport via, const std::string& command, runtimeMetrics::commandStats& stats)
+        {
+            latencyHistogram::summary summary = stats.latency_.summarize();
+            if (summary.count_ == 0)
+            {
+                return;
+            }
+            std::string labels = "transport=\"" + runtimeMetrics::transportName(via) + "\",command=\"" +
+                                 escapeLabel(command) + "\"";
+            const std::pair<const char*, double> quantiles[] = {{"0.5", summary.p50Micros_},
+                                                                {"0.9", summary.p90Micros_},
+                                                                {"0.99", summary.p99Micros_},
+                                                                {"0.999", summary.p999Micros_}};
+            for (const auto& quantile : quantiles)
+            {
+                out << "cpp_app_request_duration_seconds{" << labels << ",quantile=\"" << quantile.first << "\"} "
+                    << quantile.second / 1e6 << '\n';
+            }
+            out << "cpp_app_request_duration_seconds_sum{" << labels << "} "
+                << summary.meanMicros_ * summary.count_ / 1e6 << '\n';
+            out << "cpp_app_request_duration_seconds_count{" << labels << "} " << summary.count_ << '\n';
+        });
+
+    if (allocationTracker::enabled())
+    {
+        // Each family's samples must be contiguous, so the commands are walked once per family
+        const struct
+        {
+            const char* name_;
+            const char* help_;
+            uint64_t (allocationTracker::totals::*value_)() const;
+        } families[] = {{"cpp_app_command_allocations_total", "Heap allocations on the thread running each command.",
+                         &allocationTracker::totals::allocations},
+                        {"cpp_app_command_allocated_bytes_total",
+                         "Bytes requested from the heap on the thread running each command.",
+                         &allocationTracker::totals::bytes}};
+        for (const auto& metric : families)
+        {
+            family(out, metric.name_, "counter", metric.help_);
+            handler_.metrics().forEachCommand(
+                [&](runtimeMetrics::transport via, const std::string& command, runtimeMetrics::commandStats& stats)
+                {
+                    if (stats.allocations_.commands() == 0)
+                    {
+                        return;
+                    }
+                    out << metric.name_ << "{transport=\"" << runtimeMetrics::transportName(via) << "\",command=\""
+                        << escapeLabel(command) << "\"} " << (stats.allocations_.*metric.value_)() << '\n';
+                });
+        }
+    }
+
+    if (perfCounters::enabled())
+    {
+        family(out, "cpp_app_command_hardware_events_total", "counter",
+               "Hardware events on the thread running each command (perf_event_open, user space).");
+        handler_.metrics().forEachCommand(
+            [&](runtimeMetrics::transport via, const std::string& command, runtimeMetrics::commandStats& stats)
+            {
+                if (stats.counters_.commands() == 0)
+                {
+                    return;
+                }
+                std::string labels = "transport=\"" + runtimeMetrics::transportName(via) + "\",command=\"" +
+                                     escapeLabel(command) + "\"";
+                for (size_t i = 0; i < perfCounters::kEvents; ++i)
+                {
+                    auto which = static_cast<perfCounters::event>(i);
+                    out << "cpp_app_command_hardware_events_total{" << labels << ",event=\""
+                        << perfCounters::eventName(which) << "\"} " << stats.counters_.value(which) << '\n';
+                }
+            });
+    }
+    return out.str();
+}
+
+void metricsHttpServer::serveLoop()
+{
+    while (running_)
+    {
+        socketHandle client = accept(listenSocket_, nullptr, nullptr);
+        if (client == INVALID_SOCKET)
+        {
+            continue;
+        }
+        handleConnection(client);
+        closesocket(client);
+    }
+}
+
+void metricsHttpServer::handleConnection(socketHandle client)
+{
+    // Scrapers are served one at a time, so a slow or silent client must not hold the thread
+#ifdef SO_NOSIGPIPE
+    int noSigpipe = 1;  // BSD and macOS have no MSG_NOSIGNAL
+    setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &noSigpipe, sizeof(noSigpipe));
+#endif
+
+    std::string request;
+    char buffer[1024];
+    auto deadline = std::chrono::steady_clock::now() + kExchangeTimeout;
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < kMaxRequestBytes)
+    {
+        if (!armTimeout(client, SO_RCVTIMEO, deadline))
+        {
+            return;
+        }
+        int received = recv(client, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+        {
+            return;
+        }
+        request.append(buffer, received);
+    }
+
+    std::string status = "200 OK";
+    std::string body;
+    std::string contentType = "text/plain; version=0.0.4; charset=utf-8";
+    std::istringstream requestLine(request.substr(0, request.find("\r\n")));
+    std::string method;
+    std::string target;
+    requestLine >> method >> target;
+    if (method != "GET")
+    {
+        status = "405 Method Not Allowed";
+        body = "Only GET is supported\n";
+    }
+    else if (target != "/metrics")
+    {
+        status = "404 Not Found";
+        body = "Metrics are served at /metrics\n";
+    }
+    else
+    {
+        try
+        {
+            body = render();
+        }
+        catch (const std::exception& e)
+        {
+            status = "500 Internal Server Error";
+            body = std::string(e.what()) + "\n";
+        }
+    }
+
+    std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: " + contentType +
+                           "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" +
+                           body;
+    size_t sent = 0;
+    deadline = std::chrono::steady_clock::now() + kExchangeTimeout;
+    while (sent < response.size())
+    {
+        if (!armTimeout(client, SO_SNDTIMEO, deadline))
+        {
+            return;
+        }
+        int written = send(client, response.data() + sent, static_cast<int>(response.size() - sent), kSendFlags);
+        if (written <= 0)
+        {
+            return;
+        }
+        sent += written;
+    }
+}
+
+bool metricsHttpServer::armTimeout(socketHandle client, int option, std::chrono::steady_clock::time_point deadline)
+{
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+    if (left.count() <= 0)
+    {
+        return false;
+    }
+#ifdef _WIN32
+    DWORD timeout = static_cast<DWORD>(left.count());
+#else
+    timeval timeout{static_cast<time_t>(left.count() / 1000), static_cast<suseconds_t>(left.count() % 1000 * 1000)};
+#endif
+    return setsockopt(client, SOL_SOCKET, option, reinterpret_cast<const char*>(&timeout), sizeof(timeout)) == 0;
+}
+
+std::string metricsHttpServer::escapeLabel(const std::string& value)
+{
+    std::string escaped;
+    for (char c : value)
+    {
+        if (c == '\n')
+        {
+            escaped += "\\n";
+            continue;
+        }
+        if (c == '\\' || c == '"')
+        {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "commandHandler.hpp"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#endif
+
+// Minimal HTTP listener that serves GET /metrics in the Prometheus text format. It runs on its own thread
+// and only reads the handler's metrics and status, so scrapes never queue behind commands.
+class metricsHttpServer
+{
+  public:
+    metricsHttpServer(commandHandler& handler, const std::string& bindAddress, int port);
+    ~metricsHttpServer();
+
+    metricsHttpServer(const metricsHttpServer&) = delete;
+    metricsHttpServer& operator=(const metricsHttpServer&) = delete;
+
+    // Binds and starts serving in the background; false when the port cannot be bound
+    bool start(std::string& outError);
+
+    // The exposition text served at /metrics
+    std::string render();
+
+  private:
+#ifdef _WIN32
+    using socketHandle = SOCKET;
+#else
+    using socketHandle = int;
+#endif
+
+    commandHandler& handler_;
+    std::string bindAddress_;
+    int port_;
+    std::atomic<bool> running_;
+    socketHandle listenSocket_;
+    std::thread thread_;
+
+    void serveLoop();
+    void handleConnection(socketHandle client);
+    // Arms SO_RCVTIMEO or SO_SNDTIMEO with the time left until deadline; false once it has passed
+    static bool armTimeout(socketHandle client, int option, std::chrono::steady_clock::time_point deadline);
+    static std::string escapeLabel(const std::string& value);
+};
@@ -0,0 +1,187 @@
+#include "perfCounters.hpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace
+{
+#ifdef __linux__
+const uint64_t kConfigs[perfCounters::kEvents] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                  PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+// The thread's counters as one group led by cycles, so the kernel schedules all four onto the PMU together
+// and one read() returns them with the group's enabled and running times
+struct counterGroup
+{
+    std::array<int, perfCounters::kEvents> fds_;
+    bool opened_ = false;
+    int error_ = 0;
+
+    counterGroup()
+    {
+        fds_.fill(-1);
+    }
+
+    ~counterGroup()
+    {
+        close();
+    }
+
+    bool open()
+    {
+        for (size_t i = 0; i < perfCounters::kEvents; ++i)
+        {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = kConfigs[i];
+            attr.disabled = i == 0 ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds_[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds_[0], 0));
+            if (fds_[i] < 0)
+            {
+                error_ = errno;
+                close();
+                return false;
+            }
+        }
+        ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        opened_ = true;
+        return true;
+    }
+
+    void close()
+    {
+        for (int& fd : fds_)
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+        opened_ = false;
+    }
+};
+#endif
+}  // namespace
+
+std::atomic<bool> perfCounters::enabled_(false);
+
+void perfCounters::totals::add(const sample& before, const sample& after)
+{
+    if (!before.valid_ || !after.valid_)
+    {
+        return;
+    }
+    commands_.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < kEvents; ++i)
+    {
+        // Multiplexing scales both reads by estimates, which can make a small delta come out negative
+        if (after.values_[i] > before.values_[i])
+        {
+            values_[i].fetch_add(after.values_[i] - before.values_[i], std::memory_order_relaxed);
+        }
+    }
+}
+
+uint64_t perfCounters::totals::commands() const
+{
+    return commands_.load(std::memory_order_relaxed);
+}
+
+uint64_t perfCounters::totals::value(event which) const
+{
+    return values_[static_cast<size_t>(which)].load(std::memory_order_relaxed);
+}
+
+void perfCounters::totals::reset()
+{
+    commands_.store(0, std::memory_order_relaxed);
+    for (auto& value : values_)
+    {
+        value.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool perfCounters::enable(std::string& outError)
+{
+#ifdef __linux__
+    counterGroup probe;
+    if (!probe.open())
+    {
+        outError = std::string("perf_event_open failed: ") + std::strerror(probe.error_);
+        if (probe.error_ == ENOENT || probe.error_ == EOPNOTSUPP)
+        {
+            outError += " (no hardware counters exposed, e.g. in a virtual machine)";
+        }
+        else if (probe.error_ == EACCES || probe.error_ == EPERM)
+        {
+            outError += " (check /proc/sys/kernel/perf_event_paranoid)";
+        }
+        return false;
+    }
+    enabled_.store(true, std::memory_order_relaxed);
+    return true;
+#else
+    outError = "Hardware counters need Linux perf_event_open";
+    return false;
+#endif
+}
+
+perfCounters::sample perfCounters::read()
+{
+    sample result;
+#ifdef __linux__
+    if (!enabled())
+    {
+        return result;
+    }
+    thread_local counterGroup group;
+    if (!group.opened_ && (group.error_ != 0 || !group.open()))
+    {
+        return result;  // A thread that failed once does not retry on every command
+    }
+
+    // Layout for PERF_FORMAT_GROUP: count, time enabled, time running, then one value per counter
+    uint64_t data[3 + kEvents];
+    if (::read(group.fds_[0], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[0] != kEvents ||
+        data[2] == 0)
+    {
+        return result;
+    }
+    double scale = static_cast<double>(data[1]) / static_cast<double>(data[2]);
+    for (size_t i = 0; i < kEvents; ++i)
+    {
+        result.values_[i] = static_cast<uint64_t>(static_cast<double>(data[3 + i]) * scale);
+    }
+    result.valid_ = true;
+#endif
+    return result;
+}
+
+const char* perfCounters::eventName(event which)
+{
+    switch (which)
+    {
+        case event::cycles:
+            return "cycles";
+        case event::instructions:
+            return "instructions";
+        case event::cacheMisses:
+            return "cache_misses";
+        case event::branchMisses:
+            return "branch_misses";
+    }
+    return "unknown";
+}
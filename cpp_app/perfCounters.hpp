@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Opt-in hardware counters (Linux perf_event_open) for the thread running a command. Each thread opens one
+// counter group on its first read, so a command's cost is the difference of two reads on its own thread; work
+// it hands to other threads (render tiles, async jobs) is not included. User-space only, so the process needs
+// no privileges beyond perf_event_paranoid <= 2.
+class perfCounters
+{
+  public:
+    enum class event
+    {
+        cycles,
+        instructions,
+        cacheMisses,  // Last-level cache
+        branchMisses
+    };
+    static constexpr size_t kEvents = 4;
+
+    struct sample
+    {
+        std::array<uint64_t, kEvents> values_{};
+        bool valid_ = false;
+    };
+
+    // Sums of per-command deltas, added to from any thread
+    class totals
+    {
+      public:
+        void add(const sample& before, const sample& after);
+        uint64_t commands() const;
+        uint64_t value(event which) const;
+        void reset();
+
+      private:
+        std::atomic<uint64_t> commands_{0};
+        std::array<std::atomic<uint64_t>, kEvents> values_{};
+    };
+
+    // Checks that the counters can be opened here; until then read() returns invalid samples without a syscall
+    static bool enable(std::string& outError);
+    static bool enabled()
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    // The calling thread's counts so far, scaled for multiplexing
+    static sample read();
+
+    static const char* eventName(event which);
+
+  private:
+    static std::atomic<bool> enabled_;
+};
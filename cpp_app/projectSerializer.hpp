@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+#include "softwareCore.hpp"
+
+// Project file reading and writing - works on snapshots so it can run off the request thread
+class projectSerializer
+{
+  public:
+    // compress writes a block-compressed container; readProject detects it automatically
+    static bool writeProject(const softwareCore::sceneSnapshot& snapshot, const std::string& filename,
+                             const std::string& checkpointId = "", size_t threads = 1, bool compress = false);
+    static bool readProject(const std::string& filename, std::string& outProjectName,
+                            softwareCore::objectTable& outObjects, std::string& outCheckpointId,
+                            size_t& outDeltaSegments);
+
+    // Delta segments live in a sidecar next to the project file, one JSON line per save
+    static bool appendDelta(const softwareCore::sceneSnapshot& snapshot, const std::set<std::string>& dirtyIds,
+                            const std::set<std::string>& deletedIds, const std::string& filename,
+                            const std::string& checkpointId);
+    static void removeDeltas(const std::string& filename);
+    static std::string deltaFileName(const std::string& filename);
+
+    static nlohmann::json objectToJson(const softwareCore::softwareObject& obj);
+    static softwareCore::softwareObject objectFromJson(const nlohmann::json& obj_data);
+
+  private:
+    static bool serializeSharded(const softwareCore::sceneSnapshot& snapshot, const std::string& checkpointId,
+                                 size_t threads, std::vector<std::string>& outBuffers);
+    static bool writeBuffers(const std::string& filename, const std::vector<std::string>& buffers);
+    static bool appendLine(const std::string& filename, const std::string& line);
+    static bool trimTornLine(int fd);
+    static bool writeCompressed(const std::string& filename, const std::vector<std::string>& buffers,
+                                size_t threads);
+    static bool readCompressed(std::istream& file, std::string& outText);
+    static std::string encodeU32(uint32_t value);
+    static uint32_t decodeU32(const char* bytes);
+    static size_t applyDeltas(const std::string& filename, const std::string& checkpointId,
+                              std::string& outProjectName, softwareCore::objectTable& outObjects);
+};
@@ -0,0 +1,493 @@
+#include "rayPacketKernels.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MCP_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define MCP_TARGET_AVX2
+#else
+#define MCP_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+constexpr float kEpsilon = 1e-4f;  // Hits closer than this are self-intersections
+
+void intersectSpheresScalar(rayPacket& packet, const sphereSoA& spheres, size_t begin, size_t end,
+                            int32_t indexBase)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        float radiusSquared = spheres.radius_[i] * spheres.radius_[i];
+        for (int lane = 0; lane < rayPacket::kWidth; ++lane)
+        {
+            float ocx = packet.originX_[lane] - spheres.centerX_[i];
+            float ocy = packet.originY_[lane] - spheres.centerY_[i];
+            float ocz = packet.originZ_[lane] - spheres.centerZ_[i];
+            float b = ocx * packet.directionX_[lane] + ocy * packet.directionY_[lane] + ocz * packet.directionZ_[lane];
+            float c = ocx * ocx + ocy * ocy + ocz * ocz - radiusSquared;
+            float discriminant = b * b - c;
+            if (discriminant < 0.0f)
+            {
+                continue;
+            }
+            float root = std::sqrt(discriminant);
+            float t = -b - root;
+            if (!(t > kEpsilon))
+            {
+                t = -b + root;  // Origin inside the sphere, take the exit
+            }
+            if (t > kEpsilon && t < packet.distance_[lane])
+            {
+                packet.distance_[lane] = t;
+                packet.primitive_[lane] = indexBase + static_cast<int32_t>(i);
+            }
+        }
+    }
+}
+
+void intersectBoxesScalar(rayPacket& packet, const boxSoA& boxes, size_t begin, size_t end, int32_t indexBase)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        for (int lane = 0; lane < rayPacket::kWidth; ++lane)
+        {
+            float tx0 = (boxes.minX_[i] - packet.originX_[lane]) * packet.inverseX_[lane];
+            float tx1 = (boxes.maxX_[i] - packet.originX_[lane]) * packet.inverseX_[lane];
+            float ty0 = (boxes.minY_[i] - packet.originY_[lane]) * packet.inverseY_[lane];
+            float ty1 = (boxes.maxY_[i] - packet.originY_[lane]) * packet.inverseY_[lane];
+            float tz0 = (boxes.minZ_[i] - packet.originZ_[lane]) * packet.inverseZ_[lane];
+            float tz1 = (boxes.maxZ_[i] - packet.originZ_[lane]) * packet.inverseZ_[lane];
+            float tNear = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::min(tz0, tz1));
+            float tFar = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::max(tz0, tz1));
+
+            // A ray starting inside the box does not see it
+            if (tFar >= tNear && tNear > kEpsilon && tNear < packet.distance_[lane])
+            {
+                packet.distance_[lane] = tNear;
+                packet.primitive_[lane] = indexBase + static_cast<int32_t>(i);
+            }
+        }
+    }
+}
+
+uint32_t testBoundsScalar(const rayPacket& packet, const vec3& boundsMin, const vec3& boundsMax)
+{
+    uint32_t mask = 0;
+    for (int lane = 0; lane < rayPacket::kWidth; ++lane)
+    {
+        float tx0 = (boundsMin.x_ - packet.originX_[lane]) * packet.inverseX_[lane];
+        float tx1 = (boundsMax.x_ - packet.originX_[lane]) * packet.inverseX_[lane];
+        float ty0 = (boundsMin.y_ - packet.originY_[lane]) * packet.inverseY_[lane];
+        float ty1 = (boundsMax.y_ - packet.originY_[lane]) * packet.inverseY_[lane];
+        float tz0 = (boundsMin.z_ - packet.originZ_[lane]) * packet.inverseZ_[lane];
+        float tz1 = (boundsMax.z_ - packet.originZ_[lane]) * packet.inverseZ_[lane];
+        float tNear = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)), std::min(tz0, tz1));
+        float tFar = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)), std::max(tz0, tz1));
+
+        // Unlike primitives, a box that contains the origin still has to be entered
+        if (tFar >= tNear && tFar >= 0.0f && tNear < packet.distance_[lane])
+        {
+            mask |= 1u << lane;
+        }
+    }
+    return mask;
+}
+
+#if defined(MCP_SIMD_X86)
+// SSE2 is part of the x86-64 baseline, so these need no target attribute
+__m128 select128(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+void intersectSpheresSse(rayPacket& packet, const sphereSoA& spheres, size_t begin, size_t end, int32_t indexBase)
+{
+    const __m128 epsilon = _mm_set1_ps(kEpsilon);
+    const __m128 zero = _mm_setzero_ps();
+    for (int half = 0; half < rayPacket::kWidth; half += 4)
+    {
+        __m128 ox = _mm_load_ps(packet.originX_ + half);
+        __m128 oy = _mm_load_ps(packet.originY_ + half);
+        __m128 oz = _mm_load_ps(packet.originZ_ + half);
+        __m128 dx = _mm_load_ps(packet.directionX_ + half);
+        __m128 dy = _mm_load_ps(packet.directionY_ + half);
+        __m128 dz = _mm_load_ps(packet.directionZ_ + half);
+        __m128 distance = _mm_load_ps(packet.distance_ + half);
+        __m128 hitIndex = _mm_castsi128_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(packet.primitive_ + half)));
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            __m128 ocx = _mm_sub_ps(ox, _mm_set1_ps(spheres.centerX_[i]));
+            __m128 ocy = _mm_sub_ps(oy, _mm_set1_ps(spheres.centerY_[i]));
+            __m128 ocz = _mm_sub_ps(oz, _mm_set1_ps(spheres.centerZ_[i]));
+            __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, dx), _mm_mul_ps(ocy, dy)), _mm_mul_ps(ocz, dz));
+            __m128 c = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, ocx), _mm_mul_ps(ocy, ocy)), _mm_mul_ps(ocz, ocz));
+            c = _mm_sub_ps(c, _mm_set1_ps(spheres.radius_[i] * spheres.radius_[i]));
+            __m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), c);
+
+            __m128 root = _mm_sqrt_ps(_mm_max_ps(discriminant, zero));
+            __m128 negB = _mm_sub_ps(zero, b);
+            __m128 tEnter = _mm_sub_ps(negB, root);
+            __m128 t = select128(_mm_cmpgt_ps(tEnter, epsilon), tEnter, _mm_add_ps(negB, root));
+
+            __m128 hit = _mm_and_ps(_mm_cmpge_ps(discriminant, zero),
+                                    _mm_and_ps(_mm_cmpgt_ps(t, epsilon), _mm_cmplt_ps(t, distance)));
+            distance = select128(hit, t, distance);
+            hitIndex = select128(hit, _mm_castsi128_ps(_mm_set1_epi32(indexBase + static_cast<int32_t>(i))), hitIndex);
+        }
+
+        _mm_store_ps(packet.distance_ + half, distance);
+        _mm_store_si128(reinterpret_cast<__m128i*>(packet.primitive_ + half), _mm_castps_si128(hitIndex));
+    }
+}
+
+void intersectBoxesSse(rayPacket& packet, const boxSoA& boxes, size_t begin, size_t end, int32_t indexBase)
+{
+    const __m128 epsilon = _mm_set1_ps(kEpsilon);
+    for (int half = 0; half < rayPacket::kWidth; half += 4)
+    {
+        __m128 ox = _mm_load_ps(packet.originX_ + half);
+        __m128 oy = _mm_load_ps(packet.originY_ + half);
+        __m128 oz = _mm_load_ps(packet.originZ_ + half);
+        __m128 ix = _mm_load_ps(packet.inverseX_ + half);
+        __m128 iy = _mm_load_ps(packet.inverseY_ + half);
+        __m128 iz = _mm_load_ps(packet.inverseZ_ + half);
+        __m128 distance = _mm_load_ps(packet.distance_ + half);
+        __m128 hitIndex = _mm_castsi128_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(packet.primitive_ + half)));
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            __m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boxes.minX_[i]), ox), ix);
+            __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boxes.maxX_[i]), ox), ix);
+            __m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boxes.minY_[i]), oy), iy);
+            __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boxes.maxY_[i]), oy), iy);
+            __m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boxes.minZ_[i]), oz), iz);
+            __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boxes.maxZ_[i]), oz), iz);
+            __m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)), _mm_min_ps(tz0, tz1));
+            __m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)), _mm_max_ps(tz0, tz1));
+
+            __m128 hit = _mm_and_ps(_mm_cmpge_ps(tFar, tNear),
+                                    _mm_and_ps(_mm_cmpgt_ps(tNear, epsilon), _mm_cmplt_ps(tNear, distance)));
+            distance = select128(hit, tNear, distance);
+            hitIndex = select128(hit, _mm_castsi128_ps(_mm_set1_epi32(indexBase + static_cast<int32_t>(i))), hitIndex);
+        }
+
+        _mm_store_ps(packet.distance_ + half, distance);
+        _mm_store_si128(reinterpret_cast<__m128i*>(packet.primitive_ + half), _mm_castps_si128(hitIndex));
+    }
+}
+
+uint32_t testBoundsSse(const rayPacket& packet, const vec3& boundsMin, const vec3& boundsMax)
+{
+    const __m128 zero = _mm_setzero_ps();
+    uint32_t mask = 0;
+    for (int half = 0; half < rayPacket::kWidth; half += 4)
+    {
+        __m128 ox = _mm_load_ps(packet.originX_ + half);
+        __m128 oy = _mm_load_ps(packet.originY_ + half);
+        __m128 oz = _mm_load_ps(packet.originZ_ + half);
+        __m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMin.x_), ox), _mm_load_ps(packet.inverseX_ + half));
+        __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMax.x_), ox), _mm_load_ps(packet.inverseX_ + half));
+        __m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMin.y_), oy), _mm_load_ps(packet.inverseY_ + half));
+        __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMax.y_), oy), _mm_load_ps(packet.inverseY_ + half));
+        __m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMin.z_), oz), _mm_load_ps(packet.inverseZ_ + half));
+        __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(boundsMax.z_), oz), _mm_load_ps(packet.inverseZ_ + half));
+        __m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)), _mm_min_ps(tz0, tz1));
+        __m128 tFar = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)), _mm_max_ps(tz0, tz1));
+
+        __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(tFar, tNear), _mm_cmpge_ps(tFar, zero)),
+                                _mm_cmplt_ps(tNear, _mm_load_ps(packet.distance_ + half)));
+        mask |= static_cast<uint32_t>(_mm_movemask_ps(hit)) << half;
+    }
+    return mask;
+}
+
+MCP_TARGET_AVX2 void intersectSpheresAvx2(rayPacket& packet, const sphereSoA& spheres, size_t begin, size_t end,
+                                          int32_t indexBase)
+{
+    const __m256 epsilon = _mm256_set1_ps(kEpsilon);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 ox = _mm256_load_ps(packet.originX_);
+    __m256 oy = _mm256_load_ps(packet.originY_);
+    __m256 oz = _mm256_load_ps(packet.originZ_);
+    __m256 dx = _mm256_load_ps(packet.directionX_);
+    __m256 dy = _mm256_load_ps(packet.directionY_);
+    __m256 dz = _mm256_load_ps(packet.directionZ_);
+    __m256 distance = _mm256_load_ps(packet.distance_);
+    __m256 hitIndex = _mm256_castsi256_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(packet.primitive_)));
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        __m256 ocx = _mm256_sub_ps(ox, _mm256_set1_ps(spheres.centerX_[i]));
+        __m256 ocy = _mm256_sub_ps(oy, _mm256_set1_ps(spheres.centerY_[i]));
+        __m256 ocz = _mm256_sub_ps(oz, _mm256_set1_ps(spheres.centerZ_[i]));
+        __m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, dx), _mm256_mul_ps(ocy, dy)), _mm256_mul_ps(ocz, dz));
+        __m256 c =
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, ocx), _mm256_mul_ps(ocy, ocy)), _mm256_mul_ps(ocz, ocz));
+        c = _mm256_sub_ps(c, _mm256_set1_ps(spheres.radius_[i] * spheres.radius_[i]));
+        __m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(b, b), c);
+
+        __m256 root = _mm256_sqrt_ps(_mm256_max_ps(discriminant, zero));
+        __m256 negB = _mm256_sub_ps(zero, b);
+        __m256 tEnter = _mm256_sub_ps(negB, root);
+        __m256 t = _mm256_blendv_ps(_mm256_add_ps(negB, root), tEnter, _mm256_cmp_ps(tEnter, epsilon, _CMP_GT_OQ));
+
+        __m256 hit = _mm256_and_ps(_mm256_cmp_ps(discriminant, zero, _CMP_GE_OQ),
+                                   _mm256_and_ps(_mm256_cmp_ps(t, epsilon, _CMP_GT_OQ),
+                                                 _mm256_cmp_ps(t, distance, _CMP_LT_OQ)));
+        distance = _mm256_blendv_ps(distance, t, hit);
+        hitIndex = _mm256_blendv_ps(
+            hitIndex, _mm256_castsi256_ps(_mm256_set1_epi32(indexBase + static_cast<int32_t>(i))), hit);
+    }
+
+    _mm256_store_ps(packet.distance_, distance);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(packet.primitive_), _mm256_castps_si256(hitIndex));
+}
+
+MCP_TARGET_AVX2 void intersectBoxesAvx2(rayPacket& packet, const boxSoA& boxes, size_t begin, size_t end,
+                                        int32_t indexBase)
+{
+    const __m256 epsilon = _mm256_set1_ps(kEpsilon);
+    __m256 ox = _mm256_load_ps(packet.originX_);
+    __m256 oy = _mm256_load_ps(packet.originY_);
+    __m256 oz = _mm256_load_ps(packet.originZ_);
+    __m256 ix = _mm256_load_ps(packet.inverseX_);
+    __m256 iy = _mm256_load_ps(packet.inverseY_);
+    __m256 iz = _mm256_load_ps(packet.inverseZ_);
+    __m256 distance = _mm256_load_ps(packet.distance_);
+    __m256 hitIndex = _mm256_castsi256_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(packet.primitive_)));
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        __m256 tx0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(boxes.minX_[i]), ox), ix);
+        __m256 tx1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(boxes.maxX_[i]), ox), ix);
+        __m256 ty0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(boxes.minY_[i]), oy), iy);
+        __m256 ty1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(boxes.maxY_[i]), oy), iy);
+        __m256 tz0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(boxes.minZ_[i]), oz), iz);
+        __m256 tz1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(boxes.maxZ_[i]), oz), iz);
+        __m256 tNear = _mm256_max_ps(_mm256_max_ps(_mm256_min_ps(tx0, tx1), _mm256_min_ps(ty0, ty1)),
+                                     _mm256_min_ps(tz0, tz1));
+        __m256 tFar = _mm256_min_ps(_mm256_min_ps(_mm256_max_ps(tx0, tx1), _mm256_max_ps(ty0, ty1)),
+                                    _mm256_max_ps(tz0, tz1));
+
+        __m256 hit = _mm256_and_ps(_mm256_cmp_ps(tFar, tNear, _CMP_GE_OQ),
+                                   _mm256_and_ps(_mm256_cmp_ps(tNear, epsilon, _CMP_GT_OQ),
+                                                 _mm256_cmp_ps(tNear, distance, _CMP_LT_OQ)));
+        distance = _mm256_blendv_ps(distance, tNear, hit);
+        hitIndex = _mm256_blendv_ps(
+            hitIndex, _mm256_castsi256_ps(_mm256_set1_epi32(indexBase + static_cast<int32_t>(i))), hit);
+    }
+
+    _mm256_store_ps(packet.distance_, distance);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(packet.primitive_), _mm256_castps_si256(hitIndex));
+}
+
+MCP_TARGET_AVX2 uint32_t testBoundsAvx2(const rayPacket& packet, const vec3& boundsMin, const vec3& boundsMax)
+{
+    __m256 ox = _mm256_load_ps(packet.originX_);
+    __m256 oy = _mm256_load_ps(packet.originY_);
+    __m256 oz = _mm256_load_ps(packet.originZ_);
+    __m256 tx0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(boundsMin.x_), ox), _mm256_load_ps(packet.inverseX_));
+    __m256 tx1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(boundsMax.x_), ox), _mm256_load_ps(packet.inverseX_));
+    __m256 ty0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(boundsMin.y_), oy), _mm256_load_ps(packet.inverseY_));
+    __m256 ty1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(boundsMax.y_), oy), _mm256_load_ps(packet.inverseY_));
+    __m256 tz0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(boundsMin.z_), oz), _mm256_load_ps(packet.inverseZ_));
+    __m256 tz1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(boundsMax.z_), oz), _mm256_load_ps(packet.inverseZ_));
+    __m256 tNear =
+        _mm256_max_ps(_mm256_max_ps(_mm256_min_ps(tx0, tx1), _mm256_min_ps(ty0, ty1)), _mm256_min_ps(tz0, tz1));
+    __m256 tFar =
+        _mm256_min_ps(_mm256_min_ps(_mm256_max_ps(tx0, tx1), _mm256_max_ps(ty0, ty1)), _mm256_max_ps(tz0, tz1));
+
+    __m256 hit = _mm256_and_ps(
+        _mm256_and_ps(_mm256_cmp_ps(tFar, tNear, _CMP_GE_OQ), _mm256_cmp_ps(tFar, _mm256_setzero_ps(), _CMP_GE_OQ)),
+        _mm256_cmp_ps(tNear, _mm256_load_ps(packet.distance_), _CMP_LT_OQ));
+    return static_cast<uint32_t>(_mm256_movemask_ps(hit));
+}
+#endif
+
+const rayPacketKernels::kernelTable kScalarKernels = {rayPacketKernels::simdLevel::scalar, intersectSpheresScalar,
+                                                      intersectBoxesScalar, testBoundsScalar};
+#if defined(MCP_SIMD_X86)
+const rayPacketKernels::kernelTable kSseKernels = {rayPacketKernels::simdLevel::sse, intersectSpheresSse,
+                                                   intersectBoxesSse, testBoundsSse};
+const rayPacketKernels::kernelTable kAvx2Kernels = {rayPacketKernels::simdLevel::avx2, intersectSpheresAvx2,
+                                                    intersectBoxesAvx2, testBoundsAvx2};
+#endif
+}  // namespace
+
+void rayPacket::prepare()
+{
+    // Axis-parallel lanes get an infinite inverse, which the slab test handles
+    for (int lane = 0; lane < kWidth; ++lane)
+    {
+        inverseX_[lane] = 1.0f / directionX_[lane];
+        inverseY_[lane] = 1.0f / directionY_[lane];
+        inverseZ_[lane] = 1.0f / directionZ_[lane];
+        primitive_[lane] = -1;
+    }
+}
+
+rayPacketKernels::simdLevel rayPacketKernels::detect()
+{
+#if defined(MCP_SIMD_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    if (maxLeaf >= 7 && osSavesYmm)
+    {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5))
+        {
+            return simdLevel::avx2;
+        }
+    }
+    return sse2 ? simdLevel::sse : simdLevel::scalar;
+#elif defined(MCP_SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return simdLevel::avx2;
+    }
+    return __builtin_cpu_supports("sse2") ? simdLevel::sse : simdLevel::scalar;
+#else
+    return simdLevel::scalar;
+#endif
+}
+
+std::vector<rayPacketKernels::simdLevel> rayPacketKernels::supportedLevels()
+{
+    std::vector<simdLevel> levels = {simdLevel::scalar};
+    simdLevel best = detect();
+    if (best >= simdLevel::sse)
+    {
+        levels.push_back(simdLevel::sse);
+    }
+    if (best >= simdLevel::avx2)
+    {
+        levels.push_back(simdLevel::avx2);
+    }
+    return levels;
+}
+
+const rayPacketKernels::kernelTable& rayPacketKernels::select(simdLevel level)
+{
+#if defined(MCP_SIMD_X86)
+    level = std::min(level, detect());
+    if (level == simdLevel::avx2)
+    {
+        return kAvx2Kernels;
+    }
+    if (level == simdLevel::sse)
+    {
+        return kSseKernels;
+    }
+#endif
+    return kScalarKernels;
+}
+
+const rayPacketKernels::kernelTable& rayPacketKernels::best()
+{
+    static const kernelTable& kernels = select(detect());
+    return kernels;
+}
+
+std::string rayPacketKernels::levelName(simdLevel level)
+{
+    switch (level)
+    {
+        case simdLevel::avx2:
+            return "avx2";
+        case simdLevel::sse:
+            return "sse";
+        default:
+            return "scalar";
+    }
+}
+
+std::vector<rayPacketKernels::benchmarkResult> rayPacketKernels::benchmark(size_t primitives, size_t packets)
+{
+    // Half spheres, half boxes, scattered through a 20-unit cube; rays start inside it
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+    std::uniform_real_distribution<float> extent(0.1f, 0.6f);
+    std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+
+    sphereSoA spheres;
+    boxSoA boxes;
+    for (size_t i = 0; i < primitives; ++i)
+    {
+        float x = position(gen);
+        float y = position(gen);
+        float z = position(gen);
+        float r = extent(gen);
+        if (i % 2 == 0)
+        {
+            spheres.centerX_.push_back(x);
+            spheres.centerY_.push_back(y);
+            spheres.centerZ_.push_back(z);
+            spheres.radius_.push_back(r);
+        }
+        else
+        {
+            boxes.minX_.push_back(x - r);
+            boxes.minY_.push_back(y - r);
+            boxes.minZ_.push_back(z - r);
+            boxes.maxX_.push_back(x + r);
+            boxes.maxY_.push_back(y + r);
+            boxes.maxZ_.push_back(z + r);
+        }
+    }
+
+    std::vector<rayPacket> rays(packets);
+    for (rayPacket& packet : rays)
+    {
+        for (int lane = 0; lane < rayPacket::kWidth; ++lane)
+        {
+            float dx = direction(gen);
+            float dy = direction(gen);
+            float dz = direction(gen);
+            float inverseLength = 1.0f / std::sqrt(dx * dx + dy * dy + dz * dz + 1e-12f);
+            packet.originX_[lane] = position(gen);
+            packet.originY_[lane] = position(gen);
+            packet.originZ_[lane] = position(gen);
+            packet.directionX_[lane] = dx * inverseLength;
+            packet.directionY_[lane] = dy * inverseLength;
+            packet.directionZ_[lane] = dz * inverseLength;
+        }
+    }
+
+    std::vector<benchmarkResult> results;
+    for (simdLevel level : supportedLevels())
+    {
+        const kernelTable& kernels = select(level);
+        auto start = std::chrono::steady_clock::now();
+        for (rayPacket& packet : rays)
+        {
+            std::fill(packet.distance_, packet.distance_ + rayPacket::kWidth, 1e30f);
+            packet.prepare();
+            kernels.intersectSpheres_(packet, spheres, 0, spheres.size(), 0);
+            kernels.intersectBoxes_(packet, boxes, 0, boxes.size(), static_cast<int32_t>(spheres.size()));
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        size_t hits = 0;
+        for (const rayPacket& packet : rays)
+        {
+            hits += std::count_if(packet.primitive_, packet.primitive_ + rayPacket::kWidth,
+                                  [](int32_t index) { return index >= 0; });
+        }
+        results.push_back(
+            {level, static_cast<double>(packets * rayPacket::kWidth) / std::max(seconds, 1e-9), hits});
+    }
+    return results;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "vec3.hpp"
+
+// Struct-of-arrays primitive data, so one primitive can be broadcast against a whole packet
+struct sphereSoA
+{
+    std::vector<float> centerX_;
+    std::vector<float> centerY_;
+    std::vector<float> centerZ_;
+    std::vector<float> radius_;
+
+    size_t size() const
+    {
+        return radius_.size();
+    }
+};
+
+struct boxSoA
+{
+    std::vector<float> minX_;
+    std::vector<float> minY_;
+    std::vector<float> minZ_;
+    std::vector<float> maxX_;
+    std::vector<float> maxY_;
+    std::vector<float> maxZ_;
+
+    size_t size() const
+    {
+        return minX_.size();
+    }
+};
+
+// Eight rays laid out one per lane. distance_ holds the search limit going in and the closest
+// hit coming out; primitive_ is the hit index, or -1. A lane with distance_ 0 is inactive.
+struct rayPacket
+{
+    static constexpr int kWidth = 8;
+
+    alignas(32) float originX_[kWidth];
+    alignas(32) float originY_[kWidth];
+    alignas(32) float originZ_[kWidth];
+    alignas(32) float directionX_[kWidth];  // Unit length
+    alignas(32) float directionY_[kWidth];
+    alignas(32) float directionZ_[kWidth];
+    alignas(32) float inverseX_[kWidth];  // 1 / direction, filled by prepare()
+    alignas(32) float inverseY_[kWidth];
+    alignas(32) float inverseZ_[kWidth];
+    alignas(32) float distance_[kWidth];
+    alignas(32) int32_t primitive_[kWidth];
+
+    void prepare();
+};
+
+// Packet intersection kernels. Each ISA level processes the same eight lanes; the scalar level
+// is always available and the vector levels are picked at runtime from CPUID.
+class rayPacketKernels
+{
+  public:
+    enum class simdLevel
+    {
+        scalar,
+        sse,
+        avx2
+    };
+
+    // Kernels test primitives [begin, end) and report hits as indexBase + primitive index
+    using sphereKernel = void (*)(rayPacket& packet, const sphereSoA& spheres, size_t begin, size_t end,
+                                  int32_t indexBase);
+    using boxKernel = void (*)(rayPacket& packet, const boxSoA& boxes, size_t begin, size_t end,
+                               int32_t indexBase);
+
+    // Bit per lane whose ray enters the box before its current distance; used for BVH traversal
+    using boundsKernel = uint32_t (*)(const rayPacket& packet, const vec3& boundsMin, const vec3& boundsMax);
+
+    struct kernelTable
+    {
+        simdLevel level_;
+        sphereKernel intersectSpheres_;
+        boxKernel intersectBoxes_;
+        boundsKernel testBounds_;
+    };
+
+    struct benchmarkResult
+    {
+        simdLevel level_;
+        double raysPerSecond_;
+        size_t hits_;  // Identical across levels when the kernels agree
+    };
+
+    static simdLevel detect();
+    static std::vector<simdLevel> supportedLevels();
+    static const kernelTable& select(simdLevel level);  // Falls back to the best supported level at or below
+    static const kernelTable& best();                   // Detected once per process
+    static std::string levelName(simdLevel level);
+
+    // Traces random packets through a random scene of the given size on every supported level
+    static std::vector<benchmarkResult> benchmark(size_t primitives, size_t packets);
+};
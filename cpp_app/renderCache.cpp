@@ -0,0 +1,204 @@
+#include "renderCache.hpp"
+#include "memoryFootprint.hpp"
+#include "sceneRenderer.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+
+renderCache::renderCache()
+    : memoryBudget_(kDefaultMemoryBytes), spillBudget_(kDefaultSpillBytes), memoryBytes_(0), diskBytes_(0)
+{
+}
+
+void renderCache::configure(size_t memoryBytes, const std::string& spillDirectory, size_t spillBytes)
+{
+    slotList evicted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        memoryBudget_ = memoryBytes;
+        spillBudget_ = spillBytes;
+        spillDirectory_ = spillDirectory;
+        evictMemory(evicted);
+        evictDisk();
+    }
+}
+
+bool renderCache::find(uint64_t key, entry& outEntry)
+{
+    slot spilled;
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = memoryIndex_.find(key);
+        if (it != memoryIndex_.end())
+        {
+            memory_.splice(memory_.begin(), memory_, it->second);
+            outEntry = it->second->entry_;
+            return true;
+        }
+
+        auto onDisk = diskIndex_.find(key);
+        if (onDisk == diskIndex_.end())
+        {
+            return false;
+        }
+        // Claim the spilled slot; it comes back into memory below
+        path = spillPath(spillDirectory_, key);
+        spilled = std::move(*onDisk->second);
+        diskBytes_ -= spilled.bytes_;
+        disk_.erase(onDisk->second);
+        diskIndex_.erase(onDisk);
+    }
+
+    // Read outside the lock so other lookups are not held up by the disk
+    std::ifstream file(path, std::ios::binary);
+    std::string image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    std::remove(path.c_str());
+    if (image.size() != spilled.bytes_)
+    {
+        return false;
+    }
+
+    spilled.entry_.image_ = std::make_shared<const std::string>(std::move(image));
+    outEntry = spilled.entry_;
+    insert(key, std::move(spilled.entry_));
+    return true;
+}
+
+void renderCache::insert(uint64_t key, entry value)
+{
+    if (!value.image_)
+    {
+        return;
+    }
+
+    size_t bytes = value.image_->size();
+    slotList evicted;
+    std::string spillDirectory;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto onDisk = diskIndex_.find(key);
+        if (onDisk != diskIndex_.end())
+        {
+            diskBytes_ -= onDisk->second->bytes_;
+            std::remove(spillPath(spillDirectory_, key).c_str());
+            disk_.erase(onDisk->second);
+            diskIndex_.erase(onDisk);
+        }
+
+        auto it = memoryIndex_.find(key);
+        if (it != memoryIndex_.end())
+        {
+            memoryBytes_ -= it->second->bytes_;
+            memory_.erase(it->second);
+            memoryIndex_.erase(it);
+        }
+
+        memory_.push_front({key, std::move(value), bytes});
+        memoryIndex_[key] = memory_.begin();
+        memoryBytes_ += bytes;
+        evictMemory(evicted);
+        spillDirectory = spillDirectory_;
+    }
+
+    if (spillDirectory.empty())
+    {
+        return;
+    }
+
+    // Spill evicted images outside the lock; they only become findable once written
+    for (slot& victim : evicted)
+    {
+        std::ofstream file(spillPath(spillDirectory, victim.key_), std::ios::binary | std::ios::trunc);
+        file.write(victim.entry_.image_->data(), static_cast<std::streamsize>(victim.bytes_));
+        file.close();
+        if (file.fail())
+        {
+            continue;
+        }
+
+        victim.entry_.image_.reset();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (memoryIndex_.count(victim.key_) || diskIndex_.count(victim.key_))
+        {
+            continue;  // Re-rendered meanwhile; the newer copy wins
+        }
+        disk_.push_front(std::move(victim));
+        diskIndex_[disk_.front().key_] = disk_.begin();
+        diskBytes_ += disk_.front().bytes_;
+        evictDisk();
+    }
+}
+
+renderCache::footprint renderCache::measureMemory() const
+{
+    footprint result;
+    std::lock_guard<std::mutex> lock(mutex_);
+    result.memoryEntries_ = memory_.size();
+    result.memoryBytes_ = memoryBytes_;
+    result.diskEntries_ = disk_.size();
+    result.diskBytes_ = diskBytes_;
+    result.overheadBytes_ = memoryFootprint::listNodes(memory_) + memoryFootprint::listNodes(disk_) +
+                            memoryFootprint::hashNodes(memoryIndex_) + memoryFootprint::hashNodes(diskIndex_);
+    for (const slotList* slots : {&memory_, &disk_})
+    {
+        for (const slot& s : *slots)
+        {
+            result.overheadBytes_ +=
+                memoryFootprint::stringBytes(s.entry_.cameraId_) + memoryFootprint::stringBytes(s.entry_.simdLevel_);
+            if (s.entry_.image_)
+            {
+                result.overheadBytes_ += memoryFootprint::kSharedControlBytes + sizeof(std::string);
+            }
+        }
+    }
+    return result;
+}
+
+uint64_t renderCache::key(uint64_t sceneHash, const renderSettings& settings)
+{
+    std::ostringstream text;
+    text << sceneHash << '|' << settings.width_ << '|' << settings.height_ << '|' << settings.samplesPerPixel_ << '|'
+         << settings.fieldOfView_ << '|' << settings.cameraId_ << '|'
+         << imageEncoder::formatName(settings.format_);
+
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : text.str())
+    {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string renderCache::spillPath(const std::string& directory, uint64_t key)
+{
+    std::ostringstream path;
+    path << directory << "/render_" << std::hex << std::setfill('0') << std::setw(16) << key << ".png";
+    return path.str();
+}
+
+void renderCache::evictMemory(slotList& outEvicted)
+{
+    while (memoryBytes_ > memoryBudget_ && !memory_.empty())
+    {
+        auto last = std::prev(memory_.end());
+        memoryBytes_ -= last->bytes_;
+        memoryIndex_.erase(last->key_);
+        outEvicted.splice(outEvicted.end(), memory_, last);
+    }
+}
+
+void renderCache::evictDisk()
+{
+    while (diskBytes_ > spillBudget_ && !disk_.empty())
+    {
+        auto last = std::prev(disk_.end());
+        diskBytes_ -= last->bytes_;
+        std::remove(spillPath(spillDirectory_, last->key_).c_str());
+        diskIndex_.erase(last->key_);
+        disk_.erase(last);
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct renderSettings;
+
+// Bounded LRU of encoded render outputs, keyed by scene content and render settings. Entries evicted
+// from memory can spill to a directory and are read back on a later hit.
+class renderCache
+{
+  public:
+    struct entry
+    {
+        std::shared_ptr<const std::string> image_;  // Encoded in the format of the request
+        std::string cameraId_;
+        size_t tiles_ = 0;
+        std::string simdLevel_;
+    };
+
+    // Estimated heap held by the cache; spilled images count on disk only
+    struct footprint
+    {
+        size_t memoryEntries_ = 0;
+        size_t memoryBytes_ = 0;  // Encoded images
+        size_t diskEntries_ = 0;
+        size_t diskBytes_ = 0;
+        size_t overheadBytes_ = 0;  // List nodes, lookup tables and entry strings
+    };
+
+    static constexpr size_t kDefaultMemoryBytes = 64 * 1024 * 1024;
+    static constexpr size_t kDefaultSpillBytes = 1024 * 1024 * 1024;
+
+    renderCache();
+
+    // An empty directory disables spilling; entries already cached are kept if they still fit
+    void configure(size_t memoryBytes, const std::string& spillDirectory, size_t spillBytes);
+
+    bool find(uint64_t key, entry& outEntry);
+    void insert(uint64_t key, entry value);
+    footprint measureMemory() const;
+
+    // Everything that changes the rendered image except the scene itself
+    static uint64_t key(uint64_t sceneHash, const renderSettings& settings);
+
+  private:
+    struct slot
+    {
+        uint64_t key_;
+        entry entry_;   // image_ is null while the slot lives on disk
+        size_t bytes_;  // Encoded image size
+    };
+    using slotList = std::list<slot>;
+
+    mutable std::mutex mutex_;
+    size_t memoryBudget_;
+    size_t spillBudget_;
+    std::string spillDirectory_;
+
+    // Most recently used first
+    slotList memory_;
+    std::unordered_map<uint64_t, slotList::iterator> memoryIndex_;
+    size_t memoryBytes_;
+    slotList disk_;
+    std::unordered_map<uint64_t, slotList::iterator> diskIndex_;
+    size_t diskBytes_;
+
+    static std::string spillPath(const std::string& directory, uint64_t key);
+    void evictMemory(slotList& outEvicted);  // Caller must hold mutex_
+    void evictDisk();                        // Caller must hold mutex_
+};
@@ -0,0 +1,149 @@
+#include "runtimeMetrics.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+runtimeMetrics::runtimeMetrics()
+    : registry_(std::make_shared<registry>()), start_(std::chrono::steady_clock::now()), activeConnections_(0)
+{
+}
+
+void runtimeMetrics::add(counter which, uint64_t amount)
+{
+    std::atomic<uint64_t>& count = localShard().counts_[static_cast<size_t>(which)];
+    count.store(count.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+uint64_t runtimeMetrics::total(counter which) const
+{
+    size_t index = static_cast<size_t>(which);
+    std::lock_guard<std::mutex> lock(registry_->mutex_);
+    uint64_t sum = registry_->retired_[index];
+    for (const auto& s : registry_->shards_)
+    {
+        sum += s->counts_[index].load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+void runtimeMetrics::connectionOpened()
+{
+    activeConnections_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void runtimeMetrics::connectionClosed()
+{
+    activeConnections_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+int64_t runtimeMetrics::activeConnections() const
+{
+    return activeConnections_.load(std::memory_order_relaxed);
+}
+
+runtimeMetrics::commandStats& runtimeMetrics::statsFor(transport via, const std::string& command)
+{
+    std::lock_guard<std::mutex> lock(commandMutex_);
+    std::unique_ptr<commandStats>& stats = commands_[{via, command}];
+    if (!stats)
+    {
+        stats = std::make_unique<commandStats>();
+    }
+    return *stats;
+}
+
+void runtimeMetrics::forEachCommand(
+    const std::function<void(transport, const std::string&, commandStats&)>& visit)
+{
+    std::lock_guard<std::mutex> lock(commandMutex_);
+    for (auto& pair : commands_)
+    {
+        visit(pair.first.first, pair.first.second, *pair.second);
+    }
+}
+
+std::string runtimeMetrics::transportName(transport via)
+{
+    return via == transport::socket ? "socket" : "grpc";
+}
+
+double runtimeMetrics::uptimeSeconds() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+}
+
+runtimeMetrics::processMemory runtimeMetrics::readProcessMemory()
+{
+    processMemory memory;
+    // Lines look like "VmRSS:     12345 kB"
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        uint64_t* field = nullptr;
+        if (line.rfind("VmRSS:", 0) == 0)
+        {
+            field = &memory.rssBytes_;
+        }
+        else if (line.rfind("VmHWM:", 0) == 0)
+        {
+            field = &memory.peakRssBytes_;
+        }
+        else if (line.rfind("VmData:", 0) == 0)
+        {
+            field = &memory.heapBytes_;
+        }
+        if (field)
+        {
+            std::istringstream value(line.substr(line.find(':') + 1));
+            uint64_t kilobytes = 0;
+            value >> kilobytes;
+            *field = kilobytes * 1024;
+        }
+    }
+    return memory;
+}
+
+runtimeMetrics::shard& runtimeMetrics::localShard()
+{
+    thread_local threadShards local;
+    for (auto& entry : local.entries_)
+    {
+        if (entry.key_ == registry_.get() && !entry.owner_.expired())
+        {
+            return *entry.shard_;
+        }
+    }
+
+    // First record from this thread; drop entries of metrics objects that are gone
+    local.entries_.erase(std::remove_if(local.entries_.begin(), local.entries_.end(),
+                                        [](const threadShards::entry& entry) { return entry.owner_.expired(); }),
+                         local.entries_.end());
+    auto created = std::make_shared<shard>();
+    {
+        std::lock_guard<std::mutex> lock(registry_->mutex_);
+        registry_->shards_.push_back(created);
+    }
+    local.entries_.push_back({registry_.get(), registry_, created});
+    return *created;
+}
+
+runtimeMetrics::threadShards::~threadShards()
+{
+    for (auto& entry : entries_)
+    {
+        std::shared_ptr<registry> owner = entry.owner_.lock();
+        if (!owner)
+        {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(owner->mutex_);
+        for (size_t i = 0; i < kCounters; ++i)
+        {
+            owner->retired_[i] += entry.shard_->counts_[i].load(std::memory_order_relaxed);
+        }
+        owner->shards_.erase(std::remove(owner->shards_.begin(), owner->shards_.end(), entry.shard_),
+                             owner->shards_.end());
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "allocationTracker.hpp"
+#include "latencyHistogram.hpp"
+#include "perfCounters.hpp"
+
+// Process runtime statistics for the status command. Hot-path counters live in per-thread shards that
+// only their own thread writes, so recording is an uncontended relaxed increment; reads sum the shards.
+class runtimeMetrics
+{
+  public:
+    enum class counter
+    {
+        socketRequests,
+        grpcRequests,
+        failedRequests,
+        connectionsAccepted
+    };
+    static constexpr size_t kCounters = 4;
+
+    enum class transport
+    {
+        socket,
+        grpc
+    };
+
+    // Memory as the kernel sees it; zero where /proc/self is not available
+    struct processMemory
+    {
+        uint64_t rssBytes_ = 0;
+        uint64_t peakRssBytes_ = 0;
+        uint64_t heapBytes_ = 0;  // Data segment: heap plus private anonymous mappings
+    };
+
+    runtimeMetrics();
+
+    void add(counter which, uint64_t amount = 1);
+    uint64_t total(counter which) const;
+
+    // Socket clients currently connected; changes once per connection, so a shared atomic is enough
+    void connectionOpened();
+    void connectionClosed();
+    int64_t activeConnections() const;
+
+    // Everything recorded about one command on one transport
+    struct commandStats
+    {
+        latencyHistogram latency_;
+        perfCounters::totals counters_;         // Only added to while hardware counters are enabled
+        allocationTracker::totals allocations_;  // Only added to while allocation tracking is enabled
+    };
+
+    // Strategies look these up while setting up and keep the reference, so recording never touches the
+    // registry; repeated names share the same stats
+    commandStats& statsFor(transport via, const std::string& command);
+    void forEachCommand(const std::function<void(transport, const std::string&, commandStats&)>& visit);
+    static std::string transportName(transport via);
+
+    double uptimeSeconds() const;
+    static processMemory readProcessMemory();
+
+  private:
+    struct alignas(64) shard  // Own cache line, so threads do not share one while counting
+    {
+        std::array<std::atomic<uint64_t>, kCounters> counts_{};
+    };
+
+    // Outlives the metrics object while threads still hold shards in it
+    struct registry
+    {
+        std::mutex mutex_;
+        std::vector<std::shared_ptr<shard>> shards_;
+        std::array<uint64_t, kCounters> retired_{};  // Counts of threads that have exited
+    };
+
+    // Per-thread shards, one per metrics object the thread has recorded into; folded back on thread exit
+    struct threadShards
+    {
+        struct entry
+        {
+            const registry* key_;  // Compared on the hot path; locking owner_ would contend on its count
+            std::weak_ptr<registry> owner_;
+            std::shared_ptr<shard> shard_;
+        };
+        std::vector<entry> entries_;
+        ~threadShards();
+    };
+
+    std::shared_ptr<registry> registry_;
+    std::chrono::steady_clock::time_point start_;
+    std::atomic<int64_t> activeConnections_;
+    std::mutex commandMutex_;
+    std::map<std::pair<transport, std::string>, std::unique_ptr<commandStats>> commands_;
+
+    shard& localShard();
+};
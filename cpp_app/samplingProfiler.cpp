@@ -0,0 +1,283 @@
+#include "samplingProfiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <thread>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#endif
+
+namespace
+{
+// backtrace() called from the handler reports the handler itself and the kernel's signal trampoline first
+constexpr int kHandlerFrames = 2;
+constexpr size_t kHottestFunctions = 10;
+
+static_assert(std::atomic<int>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "The SIGPROF handler may only touch lock-free atomics");
+
+uint64_t steadyNanoseconds()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+#ifndef _WIN32
+// Demangled symbol, or module+offset for addresses without an exported symbol (addr2line resolves those)
+std::string symbolize(void* address)
+{
+    char buffer[64];
+    Dl_info info{};
+    if (dladdr(address, &info) == 0)
+    {
+        std::snprintf(buffer, sizeof(buffer), "[0x%llx]",
+                      static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(address)));
+        return buffer;
+    }
+    std::string name;
+    if (info.dli_sname)
+    {
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        name = status == 0 && demangled ? demangled : info.dli_sname;
+        std::free(demangled);
+    }
+    else
+    {
+        const char* module = info.dli_fname ? info.dli_fname : "?";
+        if (const char* slash = std::strrchr(module, '/'))
+        {
+            module = slash + 1;
+        }
+        std::snprintf(buffer, sizeof(buffer), "+0x%llx]",
+                      static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(address) -
+                                                      reinterpret_cast<uintptr_t>(info.dli_fbase)));
+        name = std::string("[") + module + buffer;
+    }
+    // ';' separates frames in the folded format
+    std::replace(name.begin(), name.end(), ';', ':');
+    return name;
+}
+#endif
+}  // namespace
+
+std::atomic<samplingProfiler::stackSample*> samplingProfiler::active_(nullptr);
+std::atomic<uint64_t> samplingProfiler::next_(0);
+std::atomic<uint64_t> samplingProfiler::dropped_(0);
+std::atomic<int> samplingProfiler::inHandler_(0);
+
+samplingProfiler& samplingProfiler::instance()
+{
+    static samplingProfiler instance;
+    return instance;
+}
+
+bool samplingProfiler::running() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return samples_ != nullptr;
+}
+
+bool samplingProfiler::start(int frequency, std::string& outError)
+{
+#ifdef _WIN32
+    outError = "The sampling profiler needs POSIX signals and interval timers";
+    return false;
+#else
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (samples_)
+    {
+        outError = "Profiler is already running";
+        return false;
+    }
+    if (frequency < 1 || frequency > kMaxFrequency)
+    {
+        outError = "frequency must be between 1 and " + std::to_string(kMaxFrequency);
+        return false;
+    }
+
+    // The first backtrace() loads the unwinder, which allocates; it must not happen inside the handler
+    void* warmup[4];
+    backtrace(warmup, 4);
+
+    if (!handlerInstalled_)
+    {
+        // Left installed after stopping: the default action for a SIGPROF still in flight would end the process.
+        // SA_RESTART keeps blocking accept() and recv() calls on other threads from failing with EINTR.
+        struct sigaction action{};
+        action.sa_handler = &samplingProfiler::onSignal;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        if (sigaction(SIGPROF, &action, nullptr) != 0)
+        {
+            outError = std::string("sigaction failed: ") + std::strerror(errno);
+            return false;
+        }
+        handlerInstalled_ = true;
+    }
+
+    // Left uninitialized so pages are only committed as samples land in them
+    samples_.reset(new stackSample[kMaxSamples]);
+    next_.store(0, std::memory_order_relaxed);
+    dropped_.store(0, std::memory_order_relaxed);
+    active_.store(samples_.get());
+
+    long interval = 1000000 / frequency;
+    itimerval timer{};
+    timer.it_interval.tv_sec = interval / 1000000;
+    timer.it_interval.tv_usec = interval % 1000000;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0)
+    {
+        outError = std::string("setitimer failed: ") + std::strerror(errno);
+        active_.store(nullptr);
+        samples_.reset();
+        return false;
+    }
+    frequency_ = frequency;
+    startedNanoseconds_ = steadyNanoseconds();
+    return true;
+#endif
+}
+
+bool samplingProfiler::stop(const std::string& path, dumpStats& outStats, std::string& outError)
+{
+#ifdef _WIN32
+    outError = "The sampling profiler needs POSIX signals and interval timers";
+    return false;
+#else
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!samples_)
+    {
+        outError = "Profiler is not running";
+        return false;
+    }
+    // Opened first, so a bad path leaves the profile running for another attempt instead of discarding it
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        outError = "Cannot open profile file: " + path;
+        return false;
+    }
+
+    itimerval disarmed{};
+    setitimer(ITIMER_PROF, &disarmed, nullptr);
+    active_.store(nullptr);
+    // A handler that loaded the buffer before the store above may still be filling its slot
+    while (inHandler_.load() != 0)
+    {
+        std::this_thread::yield();
+    }
+
+    uint64_t count = std::min<uint64_t>(next_.load(std::memory_order_relaxed), kMaxSamples);
+    write(file, count, outStats);
+    outStats.frequency_ = frequency_;
+    outStats.seconds_ = static_cast<double>(steadyNanoseconds() - startedNanoseconds_) / 1e9;
+    samples_.reset();
+    file.close();
+    if (!file)
+    {
+        outError = "Failed to write profile file: " + path;
+        return false;
+    }
+    return true;
+#endif
+}
+
+void samplingProfiler::onSignal(int)
+{
+#ifndef _WIN32
+    int savedErrno = errno;
+    // Counted before the buffer is loaded, so stop() either sees this handler or this handler sees no buffer
+    inHandler_.fetch_add(1);
+    if (stackSample* samples = active_.load())
+    {
+        uint64_t slot = next_.fetch_add(1, std::memory_order_relaxed);
+        if (slot < kMaxSamples)
+        {
+            stackSample& sample = samples[slot];
+            sample.depth_ = backtrace(sample.frames_, static_cast<int>(kMaxDepth));
+        }
+        else
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    inHandler_.fetch_sub(1);
+    errno = savedErrno;
+#endif
+}
+
+void samplingProfiler::write(std::ostream& out, uint64_t count, dumpStats& outStats)
+{
+    outStats = dumpStats();
+    outStats.samples_ = count;
+    outStats.dropped_ = dropped_.load(std::memory_order_relaxed);
+#ifndef _WIN32
+    std::unordered_map<void*, std::string> names;
+    auto nameOf = [&names](void* address) -> const std::string&
+    {
+        auto found = names.find(address);
+        if (found == names.end())
+        {
+            found = names.emplace(address, symbolize(address)).first;
+        }
+        return found->second;
+    };
+
+    std::map<std::string, uint64_t> folded;
+    std::map<std::string, uint64_t> leaves;
+    std::string stack;
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        const stackSample& sample = samples_[i];
+        stack.clear();
+        if (sample.depth_ <= kHandlerFrames)
+        {
+            stack = "[unknown]";
+        }
+        for (int frame = sample.depth_ - 1; frame >= kHandlerFrames; --frame)
+        {
+            // Outer frames hold return addresses, which can point past the end of the calling function
+            char* address = static_cast<char*>(sample.frames_[frame]);
+            if (!stack.empty())
+            {
+                stack += ';';
+            }
+            stack += nameOf(frame == kHandlerFrames ? address : address - 1);
+        }
+        ++folded[stack];
+        ++leaves[sample.depth_ > kHandlerFrames ? nameOf(sample.frames_[kHandlerFrames]) : stack];
+    }
+
+    // Heaviest stacks first, so the file also reads well without a flame graph tool
+    std::vector<std::pair<std::string, uint64_t>> lines(folded.begin(), folded.end());
+    std::stable_sort(lines.begin(), lines.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+    for (const auto& line : lines)
+    {
+        out << line.first << ' ' << line.second << '\n';
+    }
+    outStats.stacks_ = lines.size();
+
+    std::vector<std::pair<std::string, uint64_t>> hottest(leaves.begin(), leaves.end());
+    std::stable_sort(hottest.begin(), hottest.end(),
+                     [](const auto& a, const auto& b) { return a.second > b.second; });
+    for (size_t i = 0; i < hottest.size() && i < kHottestFunctions; ++i)
+    {
+        outStats.hottest_.push_back({hottest[i].first, hottest[i].second});
+    }
+#endif
+}
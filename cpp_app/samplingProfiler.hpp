@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// In-process sampling CPU profiler. While it runs, an ITIMER_PROF timer raises SIGPROF at the requested rate
+// against the process's CPU time, and the handler copies the interrupted thread's call stack into the next slot
+// of a buffer allocated up front; the handler neither allocates nor locks. Stopping symbolizes the stacks and
+// writes them folded ("outer;inner;leaf count" per line), the input format of flamegraph.pl and speedscope.
+class samplingProfiler
+{
+  public:
+    static constexpr size_t kMaxSamples = 32768;  // About 5.5 minutes at the default rate; later samples drop
+    static constexpr size_t kMaxDepth = 64;       // Deeper stacks keep their innermost frames
+    static constexpr int kDefaultFrequency = 99;  // Off the round numbers periodic work tends to run at
+    static constexpr int kMaxFrequency = 1000;
+
+    struct hotFunction
+    {
+        std::string name_;
+        uint64_t samples_ = 0;
+    };
+
+    struct dumpStats
+    {
+        uint64_t samples_ = 0;
+        uint64_t dropped_ = 0;  // Arrived with the buffer full
+        size_t stacks_ = 0;     // Distinct folded stacks written
+        int frequency_ = 0;
+        double seconds_ = 0.0;
+        std::vector<hotFunction> hottest_;  // Leaf functions by self samples, highest first
+    };
+
+    static samplingProfiler& instance();
+
+    bool running() const;
+
+    // frequency is in samples per second of CPU time, summed over all threads
+    bool start(int frequency, std::string& outError);
+
+    // Stops sampling and writes the folded stacks; the buffer is released afterwards
+    bool stop(const std::string& path, dumpStats& outStats, std::string& outError);
+
+  private:
+    struct stackSample
+    {
+        int depth_;
+        void* frames_[kMaxDepth];
+    };
+
+    // Read by the signal handler, so plain lock-free atomics rather than members behind the mutex
+    static std::atomic<stackSample*> active_;
+    static std::atomic<uint64_t> next_;
+    static std::atomic<uint64_t> dropped_;
+    static std::atomic<int> inHandler_;
+
+    mutable std::mutex mutex_;  // Serializes start and stop; never taken by the signal handler
+    std::unique_ptr<stackSample[]> samples_;
+    int frequency_ = 0;
+    uint64_t startedNanoseconds_ = 0;
+    bool handlerInstalled_ = false;
+
+    samplingProfiler() = default;
+    static void onSignal(int);
+    void write(std::ostream& out, uint64_t count, dumpStats& outStats);
+};
@@ -0,0 +1,171 @@
+#include "sceneGeometry.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+void aabb::grow(const vec3& point)
+{
+    min_ = {std::min(min_.x_, point.x_), std::min(min_.y_, point.y_), std::min(min_.z_, point.z_)};
+    max_ = {std::max(max_.x_, point.x_), std::max(max_.y_, point.y_), std::max(max_.z_, point.z_)};
+}
+
+void aabb::grow(const aabb& other)
+{
+    if (!other.empty())
+    {
+        grow(other.min_);
+        grow(other.max_);
+    }
+}
+
+bool aabb::empty() const
+{
+    return min_.x_ > max_.x_ || min_.y_ > max_.y_ || min_.z_ > max_.z_;
+}
+
+bool aabb::overlaps(const aabb& other) const
+{
+    return !empty() && !other.empty() && min_.x_ <= other.max_.x_ && max_.x_ >= other.min_.x_ &&
+           min_.y_ <= other.max_.y_ && max_.y_ >= other.min_.y_ && min_.z_ <= other.max_.z_ &&
+           max_.z_ >= other.min_.z_;
+}
+
+vec3 aabb::center() const
+{
+    return (min_ + max_) * 0.5f;
+}
+
+float aabb::surfaceArea() const
+{
+    if (empty())
+    {
+        return 0.0f;
+    }
+    vec3 extent = max_ - min_;
+    return 2.0f * (extent.x_ * extent.y_ + extent.y_ * extent.z_ + extent.z_ * extent.x_);
+}
+
+aabb scenePrimitive::bounds() const
+{
+    vec3 half = {radius_, radius_, radius_};
+    aabb box;
+    box.min_ = center_ - half;
+    box.max_ = center_ + half;
+    return box;
+}
+
+bool sceneGeometry::primitiveFromObject(const std::string& type, const std::map<std::string, std::string>& properties,
+                                        scenePrimitive& outPrimitive)
+{
+    scenePrimitive p;
+    if (type == "sphere")
+    {
+        p.shape_ = scenePrimitive::shape::sphere;
+        p.radius_ = scalarProperty(properties, "radius", 0.5f);
+    }
+    else if (type == "cube")
+    {
+        p.shape_ = scenePrimitive::shape::box;
+        p.radius_ = scalarProperty(properties, "size", 1.0f) * 0.5f;
+    }
+    else
+    {
+        return false;  // Cameras are not visible
+    }
+    if (!(p.radius_ > 0.0f))
+    {
+        return false;
+    }
+    p.center_ = vec3Property(properties, "position", {0.0f, 0.0f, 0.0f});
+    p.color_ = colorProperty(properties);
+    outPrimitive = p;
+    return true;
+}
+
+bool sceneGeometry::parseVec3(const std::string& text, vec3& outValue)
+{
+    float values[3];
+    std::stringstream ss(text);
+    std::string component;
+    for (float& value : values)
+    {
+        if (!std::getline(ss, component, ',') || !parseFloat(component, value))
+        {
+            return false;
+        }
+    }
+    outValue = {values[0], values[1], values[2]};
+    return true;
+}
+
+vec3 sceneGeometry::vec3Property(const std::map<std::string, std::string>& properties, const std::string& key,
+                                 const vec3& fallback)
+{
+    auto it = properties.find(key);
+    if (it == properties.end())
+    {
+        return fallback;
+    }
+
+    // Missing or malformed components keep the fallback
+    float values[3] = {fallback.x_, fallback.y_, fallback.z_};
+    std::stringstream ss(it->second);
+    std::string component;
+    for (int i = 0; i < 3 && std::getline(ss, component, ','); ++i)
+    {
+        parseFloat(component, values[i]);
+    }
+    return {values[0], values[1], values[2]};
+}
+
+float sceneGeometry::scalarProperty(const std::map<std::string, std::string>& properties, const std::string& key,
+                                    float fallback)
+{
+    auto it = properties.find(key);
+    float value = fallback;
+    if (it != properties.end())
+    {
+        parseFloat(it->second, value);
+    }
+    return value;
+}
+
+vec3 sceneGeometry::colorProperty(const std::map<std::string, std::string>& properties)
+{
+    static const std::map<std::string, vec3> kNamedColors = {
+        {"white", {1.0f, 1.0f, 1.0f}},  {"black", {0.0f, 0.0f, 0.0f}},   {"red", {0.9f, 0.1f, 0.1f}},
+        {"green", {0.1f, 0.8f, 0.2f}},  {"blue", {0.1f, 0.2f, 0.9f}},    {"yellow", {0.95f, 0.85f, 0.1f}},
+        {"cyan", {0.1f, 0.85f, 0.9f}},  {"magenta", {0.9f, 0.1f, 0.8f}}, {"orange", {1.0f, 0.5f, 0.05f}},
+        {"purple", {0.5f, 0.1f, 0.7f}}, {"gray", {0.5f, 0.5f, 0.5f}},    {"grey", {0.5f, 0.5f, 0.5f}}};
+
+    auto it = properties.find("color");
+    if (it == properties.end())
+    {
+        return kNamedColors.at("white");
+    }
+
+    auto named = kNamedColors.find(it->second);
+    if (named != kNamedColors.end())
+    {
+        return named->second;
+    }
+    if (it->second.size() == 7 && it->second[0] == '#')
+    {
+        unsigned long rgb = std::strtoul(it->second.c_str() + 1, nullptr, 16);
+        return {((rgb >> 16) & 0xff) / 255.0f, ((rgb >> 8) & 0xff) / 255.0f, (rgb & 0xff) / 255.0f};
+    }
+    return vec3Property(properties, "color", kNamedColors.at("white"));
+}
+
+bool sceneGeometry::parseFloat(const std::string& text, float& outValue)
+{
+    const char* begin = text.c_str();
+    char* end = nullptr;
+    float value = std::strtof(begin, &end);
+    if (end == begin)
+    {
+        return false;
+    }
+    outValue = value;
+    return true;
+}
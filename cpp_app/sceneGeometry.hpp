@@ -0,0 +1,55 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "vec3.hpp"
+
+// Axis-aligned bounding box; default constructed boxes are empty and grow from nothing
+struct aabb
+{
+    vec3 min_ = {1e30f, 1e30f, 1e30f};
+    vec3 max_ = {-1e30f, -1e30f, -1e30f};
+
+    void grow(const vec3& point);
+    void grow(const aabb& other);
+    bool empty() const;
+    bool overlaps(const aabb& other) const;
+    vec3 center() const;
+    float surfaceArea() const;
+};
+
+// Visible shape derived from an object's properties
+struct scenePrimitive
+{
+    enum class shape
+    {
+        sphere,
+        box
+    };
+
+    shape shape_ = shape::sphere;
+    vec3 center_;
+    float radius_ = 0.0f;  // Sphere radius, or half the cube edge
+    vec3 color_;
+
+    aabb bounds() const;
+};
+
+// Property parsing shared by rendering and spatial queries
+class sceneGeometry
+{
+  public:
+    // False for objects without visible geometry (cameras, zero-sized shapes)
+    static bool primitiveFromObject(const std::string& type, const std::map<std::string, std::string>& properties,
+                                    scenePrimitive& outPrimitive);
+
+    // Vectors are stored as "x,y,z"; returns false unless all three components parse
+    static bool parseVec3(const std::string& text, vec3& outValue);
+    static bool parseFloat(const std::string& text, float& outValue);
+    static vec3 vec3Property(const std::map<std::string, std::string>& properties, const std::string& key,
+                             const vec3& fallback);
+    static float scalarProperty(const std::map<std::string, std::string>& properties, const std::string& key,
+                                float fallback);
+    static vec3 colorProperty(const std::map<std::string, std::string>& properties);
+};
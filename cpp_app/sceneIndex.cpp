@@ -0,0 +1,288 @@
+#include "sceneIndex.hpp"
+#include "memoryFootprint.hpp"
+#include "threadPool.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+constexpr size_t kParseChunk = 4096;  // Objects parsed per task when building in parallel
+}  // namespace
+
+sceneIndex::sceneIndex() : refitsSinceBuild_(0)
+{
+}
+
+void sceneIndex::rebuild(const softwareCore::objectTable& objects, threadPool* pool)
+{
+    // Parse properties in parallel; the table itself can only be walked in order
+    std::vector<softwareCore::objectTable::const_iterator> entries;
+    entries.reserve(objects.size());
+    for (auto it = objects.begin(); it != objects.end(); ++it)
+    {
+        entries.push_back(it);
+    }
+    std::vector<scenePrimitive> parsed(entries.size());
+    std::vector<char> visible(entries.size(), 0);
+    auto parseChunk = [&](size_t chunk)
+    {
+        size_t end = std::min(entries.size(), (chunk + 1) * kParseChunk);
+        for (size_t i = chunk * kParseChunk; i < end; ++i)
+        {
+            const softwareCore::softwareObject& obj = *entries[i]->second;
+            visible[i] = sceneGeometry::primitiveFromObject(obj.type_, obj.properties_, parsed[i]);
+        }
+    };
+    size_t chunks = (entries.size() + kParseChunk - 1) / kParseChunk;
+    if (pool)
+    {
+        pool->parallelFor(chunks, parseChunk);
+    }
+    else
+    {
+        for (size_t chunk = 0; chunk < chunks; ++chunk)
+        {
+            parseChunk(chunk);
+        }
+    }
+
+    ids_.clear();
+    primitives_.clear();
+    bounds_.clear();
+    slots_.clear();
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (visible[i])
+        {
+            slots_[entries[i]->first] = static_cast<uint32_t>(ids_.size());
+            ids_.push_back(entries[i]->first);
+            primitives_.push_back(parsed[i]);
+            bounds_.push_back(parsed[i].bounds());
+        }
+    }
+
+    tree_.build(bounds_, pool);
+    refitsSinceBuild_ = 0;
+
+    // Lay the packed arrays out in leaf order so each leaf is a contiguous kernel range
+    const std::vector<uint32_t>& order = tree_.order();
+    spheresBefore_.assign(order.size() + 1, 0);
+    for (size_t position = 0; position < order.size(); ++position)
+    {
+        bool sphere = primitives_[order[position]].shape_ == scenePrimitive::shape::sphere;
+        spheresBefore_[position + 1] = spheresBefore_[position] + (sphere ? 1 : 0);
+    }
+    size_t sphereCount = spheresBefore_.back();
+    size_t boxCount = order.size() - sphereCount;
+    spheres_ = sphereSoA();
+    spheres_.centerX_.resize(sphereCount);
+    spheres_.centerY_.resize(sphereCount);
+    spheres_.centerZ_.resize(sphereCount);
+    spheres_.radius_.resize(sphereCount);
+    boxes_ = boxSoA();
+    boxes_.minX_.resize(boxCount);
+    boxes_.minY_.resize(boxCount);
+    boxes_.minZ_.resize(boxCount);
+    boxes_.maxX_.resize(boxCount);
+    boxes_.maxY_.resize(boxCount);
+    boxes_.maxZ_.resize(boxCount);
+    hitSlots_.assign(order.size(), 0);
+    for (uint32_t slot = 0; slot < primitives_.size(); ++slot)
+    {
+        writePacked(slot);
+    }
+}
+
+bool sceneIndex::update(const softwareCore::objectTable& objects, const std::set<std::string>& changed)
+{
+    std::vector<uint32_t> refitted;
+    for (const std::string& id : changed)
+    {
+        auto object = objects.find(id);
+        auto slot = slots_.find(id);
+        scenePrimitive p;
+        bool visible = object != objects.end() &&
+                       sceneGeometry::primitiveFromObject(object->second->type_, object->second->properties_, p);
+
+        if (slot == slots_.end())
+        {
+            if (visible)
+            {
+                return false;  // New geometry has no leaf to go into
+            }
+            continue;
+        }
+
+        uint32_t index = slot->second;
+        if (!visible)
+        {
+            // Removed objects leave an empty slot behind until the next rebuild
+            slots_.erase(slot);
+            ids_[index].clear();
+            bounds_[index] = aabb();
+            clearPacked(index);
+        }
+        else
+        {
+            if (p.shape_ != primitives_[index].shape_)
+            {
+                return false;
+            }
+            primitives_[index] = p;
+            bounds_[index] = p.bounds();
+            writePacked(index);
+        }
+        refitted.push_back(index);
+    }
+
+    tree_.refit(bounds_, refitted);
+
+    // Refitted nodes grow looser as objects drift away from where the tree was built
+    refitsSinceBuild_ += refitted.size();
+    return refitsSinceBuild_ <= std::max(kMinRefitBudget, primitives_.size() / 4);
+}
+
+void sceneIndex::intersect(rayPacket& packet, const rayPacketKernels::kernelTable& kernels) const
+{
+    packet.prepare();
+    const std::vector<bvh::node>& nodes = tree_.nodes();
+    if (nodes.empty())
+    {
+        return;
+    }
+
+    const float* direction[3] = {packet.directionX_, packet.directionY_, packet.directionZ_};
+    int32_t boxBase = static_cast<int32_t>(spheres_.size());
+    uint32_t stack[bvh::kMaxDepth * 2];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0)
+    {
+        const bvh::node& n = nodes[stack[--top]];
+        if (n.bounds_.empty() || !kernels.testBounds_(packet, n.bounds_.min_, n.bounds_.max_))
+        {
+            continue;
+        }
+
+        if (n.count_ > 0)
+        {
+            uint32_t begin = n.first_;
+            uint32_t end = n.first_ + n.count_;
+            kernels.intersectSpheres_(packet, spheres_, spheresBefore_[begin], spheresBefore_[end], 0);
+            kernels.intersectBoxes_(packet, boxes_, begin - spheresBefore_[begin], end - spheresBefore_[end],
+                                    boxBase);
+            continue;
+        }
+
+        // Visit the child on the near side of the split first so later nodes are culled by distance
+        bool reversed = direction[n.axis_][0] < 0.0f;
+        stack[top++] = reversed ? n.first_ : n.first_ + 1;
+        stack[top++] = reversed ? n.first_ + 1 : n.first_;
+    }
+
+    for (int lane = 0; lane < rayPacket::kWidth; ++lane)
+    {
+        if (packet.primitive_[lane] >= 0)
+        {
+            packet.primitive_[lane] = static_cast<int32_t>(hitSlots_[packet.primitive_[lane]]);
+        }
+    }
+}
+
+void sceneIndex::queryRegion(const aabb& region, std::vector<std::string>& outIds) const
+{
+    std::vector<uint32_t> slots;
+    tree_.queryOverlap(region, bounds_, slots);
+    std::sort(slots.begin(), slots.end());
+    for (uint32_t slot : slots)
+    {
+        outIds.push_back(ids_[slot]);
+    }
+}
+
+const scenePrimitive& sceneIndex::primitive(uint32_t slot) const
+{
+    return primitives_[slot];
+}
+
+const std::string& sceneIndex::objectId(uint32_t slot) const
+{
+    return ids_[slot];
+}
+
+size_t sceneIndex::size() const
+{
+    return slots_.size();
+}
+
+softwareCore::indexFootprint sceneIndex::measureMemory() const
+{
+    softwareCore::indexFootprint result;
+    result.slots_ = slots_.size();
+    result.bvhBytes_ = tree_.memoryBytes();
+    result.slotBytes_ = memoryFootprint::vectorBytes(ids_) + memoryFootprint::vectorBytes(primitives_) +
+                        memoryFootprint::vectorBytes(bounds_) + memoryFootprint::hashNodes(slots_);
+    for (const auto& id : ids_)
+    {
+        result.slotBytes_ += memoryFootprint::stringBytes(id);
+    }
+    for (const auto& slot : slots_)
+    {
+        result.slotBytes_ += memoryFootprint::stringBytes(slot.first);
+    }
+    for (const auto* values : {&spheres_.centerX_, &spheres_.centerY_, &spheres_.centerZ_, &spheres_.radius_,
+                               &boxes_.minX_, &boxes_.minY_, &boxes_.minZ_, &boxes_.maxX_, &boxes_.maxY_,
+                               &boxes_.maxZ_})
+    {
+        result.packedBytes_ += memoryFootprint::vectorBytes(*values);
+    }
+    result.packedBytes_ += memoryFootprint::vectorBytes(spheresBefore_) + memoryFootprint::vectorBytes(hitSlots_);
+    return result;
+}
+
+uint32_t sceneIndex::packedIndex(uint32_t slot) const
+{
+    uint32_t position = tree_.position(slot);
+    bool sphere = primitives_[slot].shape_ == scenePrimitive::shape::sphere;
+    return sphere ? spheresBefore_[position] : position - spheresBefore_[position];
+}
+
+void sceneIndex::writePacked(uint32_t slot)
+{
+    const scenePrimitive& p = primitives_[slot];
+    uint32_t index = packedIndex(slot);
+    if (p.shape_ == scenePrimitive::shape::sphere)
+    {
+        spheres_.centerX_[index] = p.center_.x_;
+        spheres_.centerY_[index] = p.center_.y_;
+        spheres_.centerZ_[index] = p.center_.z_;
+        spheres_.radius_[index] = p.radius_;
+        hitSlots_[index] = slot;
+    }
+    else
+    {
+        boxes_.minX_[index] = p.center_.x_ - p.radius_;
+        boxes_.minY_[index] = p.center_.y_ - p.radius_;
+        boxes_.minZ_[index] = p.center_.z_ - p.radius_;
+        boxes_.maxX_[index] = p.center_.x_ + p.radius_;
+        boxes_.maxY_[index] = p.center_.y_ + p.radius_;
+        boxes_.maxZ_[index] = p.center_.z_ + p.radius_;
+        hitSlots_[spheres_.size() + index] = slot;
+    }
+}
+
+void sceneIndex::clearPacked(uint32_t slot)
+{
+    // NaN fails every comparison in the kernels, so the slot can never be hit
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    uint32_t index = packedIndex(slot);
+    if (primitives_[slot].shape_ == scenePrimitive::shape::sphere)
+    {
+        spheres_.radius_[index] = nan;
+    }
+    else
+    {
+        boxes_.minX_[index] = boxes_.minY_[index] = boxes_.minZ_[index] = nan;
+        boxes_.maxX_[index] = boxes_.maxY_[index] = boxes_.maxZ_[index] = nan;
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bvh.hpp"
+#include "rayPacketKernels.hpp"
+#include "sceneGeometry.hpp"
+#include "softwareCore.hpp"
+
+class threadPool;
+
+// Spatial index over the visible objects of one scene version, shared by render and the spatial
+// queries. Changes to indexed objects refit the BVH in place; new objects need a rebuild.
+class sceneIndex
+{
+  public:
+    sceneIndex();
+
+    void rebuild(const softwareCore::objectTable& objects, threadPool* pool);
+
+    // Applies the listed object changes; false means the caller has to rebuild instead
+    bool update(const softwareCore::objectTable& objects, const std::set<std::string>& changed);
+
+    // Closest hit per lane within distance_; primitive_ holds a slot (see primitive()) afterwards
+    void intersect(rayPacket& packet, const rayPacketKernels::kernelTable& kernels) const;
+    void queryRegion(const aabb& region, std::vector<std::string>& outIds) const;
+
+    const scenePrimitive& primitive(uint32_t slot) const;
+    const std::string& objectId(uint32_t slot) const;
+    size_t size() const;
+    softwareCore::indexFootprint measureMemory() const;
+
+  private:
+    static constexpr size_t kMinRefitBudget = 64;  // Refits tolerated before a rebuild, for small scenes
+
+    std::vector<std::string> ids_;  // Empty for slots whose object was removed since the build
+    std::vector<scenePrimitive> primitives_;
+    std::vector<aabb> bounds_;
+    std::unordered_map<std::string, uint32_t> slots_;
+    bvh tree_;
+    size_t refitsSinceBuild_;
+
+    // Packed copies in leaf order for the packet kernels. Hit indices address spheres first,
+    // then boxes, and map back to slots through hitSlots_.
+    sphereSoA spheres_;
+    boxSoA boxes_;
+    std::vector<uint32_t> spheresBefore_;  // Spheres among the first i leaf-order positions
+    std::vector<uint32_t> hitSlots_;
+
+    uint32_t packedIndex(uint32_t slot) const;
+    void writePacked(uint32_t slot);
+    void clearPacked(uint32_t slot);
+};
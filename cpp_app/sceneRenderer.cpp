@@ -0,0 +1,642 @@
+#include "sceneRenderer.hpp"
+#include "imageEncoder.hpp"
+#include "memoryFootprint.hpp"
+#include "sceneIndex.hpp"
+#include "sharedFramebuffer.hpp"
+#include "threadPool.hpp"
+#include "traceRecorder.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace
+{
+constexpr float kPi = 3.14159265358979f;
+constexpr float kAmbient = 0.15f;
+constexpr int kMaxImageSize = 8192;
+constexpr int kMaxSamples = 1024;
+
+// Rotates v by Euler angles in degrees, applied as roll (z), then pitch (x), then yaw (y)
+vec3 rotate(const vec3& v, const vec3& degrees)
+{
+    float rx = degrees.x_ * kPi / 180.0f;
+    float ry = degrees.y_ * kPi / 180.0f;
+    float rz = degrees.z_ * kPi / 180.0f;
+
+    vec3 r = {v.x_ * std::cos(rz) - v.y_ * std::sin(rz), v.x_ * std::sin(rz) + v.y_ * std::cos(rz), v.z_};
+    r = {r.x_, r.y_ * std::cos(rx) - r.z_ * std::sin(rx), r.y_ * std::sin(rx) + r.z_ * std::cos(rx)};
+    return {r.x_ * std::cos(ry) + r.z_ * std::sin(ry), r.y_, -r.x_ * std::sin(ry) + r.z_ * std::cos(ry)};
+}
+
+bool parseInt(const std::map<std::string, std::string>& params, const std::string& key, int minValue,
+              int maxValue, int& outValue, std::string& outError)
+{
+    auto it = params.find(key);
+    if (it == params.end())
+    {
+        return true;
+    }
+
+    const char* begin = it->second.c_str();
+    char* end = nullptr;
+    long value = std::strtol(begin, &end, 10);
+    if (end == begin || *end != '\0' || value < minValue || value > maxValue)
+    {
+        outError = "Invalid " + key + ": expected an integer in [" + std::to_string(minValue) + ", " +
+                   std::to_string(maxValue) + "]";
+        return false;
+    }
+    outValue = static_cast<int>(value);
+    return true;
+}
+
+// Cheap per-pixel hash so sample jitter is identical from run to run
+uint32_t hashPixel(uint32_t x, uint32_t y, uint32_t sample)
+{
+    uint32_t h = x * 73856093u ^ y * 19349663u ^ sample * 83492791u;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
+}  // namespace
+
+sceneRenderer::sceneRenderer(threadPool& pool) : pool_(pool), kernels_(rayPacketKernels::best())
+{
+}
+
+sceneRenderer::~sceneRenderer() = default;
+
+bool sceneRenderer::parseSettings(const std::map<std::string, std::string>& params, renderSettings& outSettings,
+                                  std::string& outError)
+{
+    renderSettings settings;
+    if (!parseInt(params, "width", 1, kMaxImageSize, settings.width_, outError) ||
+        !parseInt(params, "height", 1, kMaxImageSize, settings.height_, outError) ||
+        !parseInt(params, "samples", 1, kMaxSamples, settings.samplesPerPixel_, outError))
+    {
+        return false;
+    }
+
+    auto fov = params.find("fov");
+    if (fov != params.end())
+    {
+        if (!sceneGeometry::parseFloat(fov->second, settings.fieldOfView_) || settings.fieldOfView_ <= 0.0f ||
+            settings.fieldOfView_ >= 180.0f)
+        {
+            outError = "Invalid fov: expected degrees in (0, 180)";
+            return false;
+        }
+    }
+
+    auto camera = params.find("camera");
+    if (camera != params.end())
+    {
+        settings.cameraId_ = camera->second;
+    }
+    auto incremental = params.find("incremental");
+    if (incremental != params.end())
+    {
+        settings.incremental_ = incremental->second != "false" && incremental->second != "0";
+    }
+    auto format = params.find("format");
+    if (format != params.end() && !imageEncoder::parseFormat(format->second, settings.format_))
+    {
+        outError = "Invalid format: expected png, png_stored or ppm";
+        return false;
+    }
+    auto target = params.find("output");
+    if (target != params.end() && target->second != "file")
+    {
+        if (target->second != "shm")
+        {
+            outError = "Invalid output: expected file or shm";
+            return false;
+        }
+        auto name = params.find("shm_name");
+        settings.sharedMemoryName_ = name != params.end() ? name->second : "/cpp_app_framebuffer";
+        if (!sharedFramebuffer::validName(settings.sharedMemoryName_))
+        {
+            outError = "Invalid shm_name: expected '/' followed by a name without further slashes";
+            return false;
+        }
+    }
+    auto output = params.find("output_file");
+    if (output != params.end() && !output->second.empty())
+    {
+        settings.outputFile_ = output->second;
+    }
+
+    outSettings = settings;
+    return true;
+}
+
+bool sceneRenderer::render(const softwareCore::sceneSnapshot& scene, const sceneIndex& index,
+                           const renderSettings& settings, renderResult& outResult, std::string& outError,
+                           const softwareCore::progressCallback& progress)
+{
+    std::vector<renderResult> results;
+    if (!renderViews(scene, index, {settings}, results, outError, progress))
+    {
+        return false;
+    }
+    outResult = std::move(results.front());
+    return true;
+}
+
+bool sceneRenderer::renderViews(const softwareCore::sceneSnapshot& scene, const sceneIndex& index,
+                                const std::vector<renderSettings>& views, std::vector<renderResult>& outResults,
+                                std::string& outError, const softwareCore::progressCallback& progress)
+{
+    traceSpan span("sceneRenderer::renderViews", "render");
+    auto start = std::chrono::steady_clock::now();
+
+    struct viewState
+    {
+        camera cam_;
+        std::string cameraId_;
+        size_t tileCount_ = 0;
+        std::vector<size_t> tiles_;
+        std::vector<uint8_t> framebuffer_;
+    };
+    std::vector<viewState> states(views.size());
+
+    // From the same view, start from the camera's previous image and re-trace only tiles that changed
+    // objects covered before or after. Streams always send every tile.
+    std::vector<std::pair<size_t, size_t>> work;  // (view, tile) across all views, traced in one pass
+    for (size_t v = 0; v < views.size(); ++v)
+    {
+        const renderSettings& settings = views[v];
+        viewState& state = states[v];
+        if (!findCamera(*scene.objects_, settings, state.cam_, state.cameraId_, outError))
+        {
+            return false;
+        }
+
+        size_t tilesX = (settings.width_ + kTileSize - 1) / kTileSize;
+        size_t tilesY = (settings.height_ + kTileSize - 1) / kTileSize;
+        state.tileCount_ = tilesX * tilesY;
+
+        std::shared_ptr<const frame> previous;
+        {
+            std::lock_guard<std::mutex> lock(frameMutex_);
+            auto it = lastFrames_.find(state.cameraId_);
+            if (it != lastFrames_.end())
+            {
+                previous = it->second;
+            }
+        }
+        if (settings.incremental_ && !settings.tileSink_ && previous && sameView(*previous, settings, state.cam_))
+        {
+            state.framebuffer_ = previous->pixels_;
+            std::vector<char> dirtyTiles(state.tileCount_, 0);
+            if (previous->objects_ != scene.objects_)
+            {
+                markChangedTiles(*previous->objects_, *scene.objects_, state.cam_, settings, dirtyTiles);
+            }
+            for (size_t tile = 0; tile < state.tileCount_; ++tile)
+            {
+                if (dirtyTiles[tile])
+                {
+                    state.tiles_.push_back(tile);
+                }
+            }
+        }
+        else
+        {
+            state.framebuffer_.assign(static_cast<size_t>(settings.width_) * settings.height_ * 3, 0);
+            state.tiles_.resize(state.tileCount_);
+            for (size_t tile = 0; tile < state.tileCount_; ++tile)
+            {
+                state.tiles_[tile] = tile;
+            }
+        }
+        for (size_t tile : state.tiles_)
+        {
+            work.emplace_back(v, tile);
+        }
+    }
+
+    // Tiles write disjoint pixel ranges, so the framebuffers need no locking
+    std::atomic<size_t> tilesDone(0);
+    std::atomic<bool> cancelled(false);
+    pool_.parallelFor(work.size(),
+                      [&](size_t i)
+                      {
+                          if (cancelled.load(std::memory_order_relaxed))
+                          {
+                              return;
+                          }
+                          const renderSettings& settings = views[work[i].first];
+                          viewState& state = states[work[i].first];
+                          size_t tile = work[i].second;
+                          traceSpan tileSpan("sceneRenderer::tile", "render");
+                          renderTile(state.cam_, index, settings, tile, state.framebuffer_);
+                          tileSpan.end();
+                          size_t done = tilesDone.fetch_add(1) + 1;
+                          bool keepGoing = !progress || progress(static_cast<double>(done) / work.size());
+                          if (keepGoing && settings.tileSink_)
+                          {
+                              renderTileUpdate update = copyTile(settings, tile, state.framebuffer_);
+                              update.tilesDone_ = done;
+                              update.tileCount_ = state.tileCount_;
+                              keepGoing = settings.tileSink_(update);
+                          }
+                          if (!keepGoing)
+                          {
+                              cancelled.store(true, std::memory_order_relaxed);
+                          }
+                      });
+    if (cancelled.load())
+    {
+        outError = "Render cancelled";
+        return false;
+    }
+
+    std::vector<renderResult> results(views.size());
+    for (size_t v = 0; v < views.size(); ++v)
+    {
+        const renderSettings& settings = views[v];
+        viewState& state = states[v];
+        renderResult& result = results[v];
+
+        // Shared-memory output skips encoding and the disk; readers map the raw pixels
+        if (!settings.sharedMemoryName_.empty())
+        {
+            if (!sharedOutput(settings.sharedMemoryName_)
+                     .publish(settings.width_, settings.height_, state.framebuffer_, result.frame_, outError))
+            {
+                return false;
+            }
+            result.sharedMemoryName_ = settings.sharedMemoryName_;
+        }
+        else
+        {
+            traceSpan encodeSpan("sceneRenderer::encode", "render");
+            auto image = std::make_shared<const std::string>(imageEncoder::encode(
+                settings.format_, settings.width_, settings.height_, state.framebuffer_, &pool_));
+            if (!imageEncoder::writeFile(settings.outputFile_, *image))
+            {
+                outError = "Could not write image file: " + settings.outputFile_;
+                return false;
+            }
+            encodeSpan.end();
+            result.outputFile_ = settings.outputFile_;
+            result.image_ = std::move(image);
+        }
+
+        result.cameraId_ = state.cameraId_;
+        result.width_ = settings.width_;
+        result.height_ = settings.height_;
+        result.samplesPerPixel_ = settings.samplesPerPixel_;
+        result.tiles_ = state.tileCount_;
+        result.tilesTraced_ = state.tiles_.size();
+        result.renderMilliseconds_ =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        result.simdLevel_ = rayPacketKernels::levelName(kernels_.level_);
+    }
+
+    std::lock_guard<std::mutex> lock(frameMutex_);
+    for (size_t v = 0; v < views.size(); ++v)
+    {
+        auto finished = std::make_shared<frame>();
+        finished->width_ = views[v].width_;
+        finished->height_ = views[v].height_;
+        finished->samplesPerPixel_ = views[v].samplesPerPixel_;
+        finished->camera_ = states[v].cam_;
+        finished->objects_ = scene.objects_;
+        finished->pixels_ = std::move(states[v].framebuffer_);
+        lastFrames_[states[v].cameraId_] = std::move(finished);
+    }
+    // Forget the frames of cameras that no longer exist
+    for (auto it = lastFrames_.begin(); it != lastFrames_.end();)
+    {
+        if (!it->first.empty() && !scene.objects_->count(it->first))
+        {
+            it = lastFrames_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    outResults = std::move(results);
+    return true;
+}
+
+softwareCore::frameFootprint sceneRenderer::measureMemory()
+{
+    softwareCore::frameFootprint result;
+    std::lock_guard<std::mutex> lock(frameMutex_);
+    result.frames_ = lastFrames_.size();
+    result.bytes_ = memoryFootprint::treeNodes(lastFrames_);
+    for (const auto& entry : lastFrames_)
+    {
+        result.bytes_ += memoryFootprint::stringBytes(entry.first) + memoryFootprint::kSharedControlBytes +
+                         sizeof(frame) + memoryFootprint::vectorBytes(entry.second->pixels_);
+    }
+    return result;
+}
+
+sharedFramebuffer& sceneRenderer::sharedOutput(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(sharedOutputMutex_);
+    std::unique_ptr<sharedFramebuffer>& output = sharedOutputs_[name];
+    if (!output)
+    {
+        output = std::make_unique<sharedFramebuffer>(name);
+    }
+    return *output;
+}
+
+bool sceneRenderer::sameView(const frame& previous, const renderSettings& settings, const camera& cam)
+{
+    const camera& last = previous.camera_;
+    auto same = [](const vec3& a, const vec3& b) { return a.x_ == b.x_ && a.y_ == b.y_ && a.z_ == b.z_; };
+    return previous.width_ == settings.width_ && previous.height_ == settings.height_ &&
+           previous.samplesPerPixel_ == settings.samplesPerPixel_ && same(last.origin_, cam.origin_) &&
+           same(last.forward_, cam.forward_) && same(last.right_, cam.right_) && same(last.up_, cam.up_) &&
+           last.tanHalfFov_ == cam.tanHalfFov_ && last.aspect_ == cam.aspect_;
+}
+
+void sceneRenderer::markChangedTiles(const softwareCore::objectTable& before, const softwareCore::objectTable& after,
+                                     const camera& cam, const renderSettings& settings, std::vector<char>& dirtyTiles)
+{
+    // Objects are immutable once published, so an unchanged object is the same pointer in both tables
+    auto markObject = [&](const softwareCore::softwareObject& obj)
+    {
+        scenePrimitive p;
+        if (sceneGeometry::primitiveFromObject(obj.type_, obj.properties_, p))
+        {
+            markTiles(p.bounds(), cam, settings, dirtyTiles);
+        }
+    };
+
+    auto a = before.begin();
+    auto b = after.begin();
+    while (a != before.end() || b != after.end())
+    {
+        if (b == after.end() || (a != before.end() && a->first < b->first))
+        {
+            markObject(*a->second);  // Deleted
+            ++a;
+        }
+        else if (a == before.end() || b->first < a->first)
+        {
+            markObject(*b->second);  // Created
+            ++b;
+        }
+        else
+        {
+            if (a->second != b->second)
+            {
+                markObject(*a->second);
+                markObject(*b->second);
+            }
+            ++a;
+            ++b;
+        }
+    }
+}
+
+void sceneRenderer::markTiles(const aabb& bounds, const camera& cam, const renderSettings& settings,
+                              std::vector<char>& dirtyTiles)
+{
+    // The projection of a box lies within the screen rectangle spanned by its projected corners.
+    // Corners at or behind the eye cannot be projected, so the whole image is marked instead.
+    float minX = 1e30f;
+    float minY = 1e30f;
+    float maxX = -1e30f;
+    float maxY = -1e30f;
+    bool wholeImage = false;
+    for (int corner = 0; corner < 8 && !wholeImage; ++corner)
+    {
+        vec3 point = {corner & 1 ? bounds.max_.x_ : bounds.min_.x_, corner & 2 ? bounds.max_.y_ : bounds.min_.y_,
+                      corner & 4 ? bounds.max_.z_ : bounds.min_.z_};
+        vec3 offset = point - cam.origin_;
+        float depth = offset.dot(cam.forward_);
+        if (depth <= 1e-4f)
+        {
+            wholeImage = true;
+            break;
+        }
+        float u = offset.dot(cam.right_) / depth;
+        float v = offset.dot(cam.up_) / depth;
+        float x = (u / (cam.aspect_ * cam.tanHalfFov_) + 1.0f) * 0.5f * settings.width_;
+        float y = (1.0f - v / cam.tanHalfFov_) * 0.5f * settings.height_;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+    }
+
+    int tilesX = (settings.width_ + kTileSize - 1) / kTileSize;
+    int tilesY = (settings.height_ + kTileSize - 1) / kTileSize;
+    int tileX0 = 0;
+    int tileY0 = 0;
+    int tileX1 = tilesX - 1;
+    int tileY1 = tilesY - 1;
+    if (!wholeImage)
+    {
+        // One pixel of margin covers rounding and the sample jitter
+        if (maxX < -1.0f || maxY < -1.0f || minX > settings.width_ + 1.0f || minY > settings.height_ + 1.0f)
+        {
+            return;
+        }
+        tileX0 = std::max(0, static_cast<int>(std::floor((minX - 1.0f) / kTileSize)));
+        tileY0 = std::max(0, static_cast<int>(std::floor((minY - 1.0f) / kTileSize)));
+        tileX1 = std::min(tilesX - 1, static_cast<int>(std::floor((maxX + 1.0f) / kTileSize)));
+        tileY1 = std::min(tilesY - 1, static_cast<int>(std::floor((maxY + 1.0f) / kTileSize)));
+    }
+    for (int ty = tileY0; ty <= tileY1; ++ty)
+    {
+        for (int tx = tileX0; tx <= tileX1; ++tx)
+        {
+            dirtyTiles[static_cast<size_t>(ty) * tilesX + tx] = 1;
+        }
+    }
+}
+
+bool sceneRenderer::findCamera(const softwareCore::objectTable& objects, const renderSettings& settings,
+                               camera& outCamera, std::string& outCameraId, std::string& outError)
+{
+    const softwareCore::softwareObject* found = nullptr;
+    if (!settings.cameraId_.empty())
+    {
+        auto it = objects.find(settings.cameraId_);
+        if (it == objects.end() || it->second->type_ != "camera")
+        {
+            outError = "Camera not found: " + settings.cameraId_;
+            return false;
+        }
+        found = it->second.get();
+        outCameraId = it->first;
+    }
+    else
+    {
+        for (const auto& pair : objects)
+        {
+            if (pair.second->type_ == "camera")
+            {
+                found = pair.second.get();
+                outCameraId = pair.first;
+                break;
+            }
+        }
+    }
+
+    // Without a camera object, fall back to the default camera placement
+    vec3 position = {0.0f, 0.0f, 5.0f};
+    vec3 rotation;
+    if (found)
+    {
+        position = sceneGeometry::vec3Property(found->properties_, "position", position);
+        rotation = sceneGeometry::vec3Property(found->properties_, "rotation", rotation);
+    }
+
+    // Unrotated cameras look down -Z with +Y up
+    outCamera.origin_ = position;
+    outCamera.forward_ = rotate({0.0f, 0.0f, -1.0f}, rotation).normalized();
+    outCamera.right_ = rotate({1.0f, 0.0f, 0.0f}, rotation).normalized();
+    outCamera.up_ = rotate({0.0f, 1.0f, 0.0f}, rotation).normalized();
+    outCamera.tanHalfFov_ = std::tan(settings.fieldOfView_ * 0.5f * kPi / 180.0f);
+    outCamera.aspect_ = static_cast<float>(settings.width_) / static_cast<float>(settings.height_);
+    return true;
+}
+
+vec3 sceneRenderer::shade(const rayPacket& packet, int lane, const sceneIndex& index)
+{
+    vec3 direction = {packet.directionX_[lane], packet.directionY_[lane], packet.directionZ_[lane]};
+    if (packet.primitive_[lane] < 0)
+    {
+        // Vertical sky gradient
+        float t = 0.5f * (direction.y_ + 1.0f);
+        return vec3{1.0f, 1.0f, 1.0f} * (1.0f - t) + vec3{0.5f, 0.7f, 1.0f} * t;
+    }
+
+    const scenePrimitive& p = index.primitive(packet.primitive_[lane]);
+    vec3 origin = {packet.originX_[lane], packet.originY_[lane], packet.originZ_[lane]};
+    vec3 local = origin + direction * packet.distance_[lane] - p.center_;
+    vec3 normal;
+    if (p.shape_ == scenePrimitive::shape::sphere)
+    {
+        normal = local * (1.0f / p.radius_);
+    }
+    else
+    {
+        // The face that was hit is the axis where the point lies furthest out
+        int axis = 0;
+        for (int i = 1; i < 3; ++i)
+        {
+            if (std::fabs(local[i]) > std::fabs(local[axis]))
+            {
+                axis = i;
+            }
+        }
+        float sign = local[axis] < 0.0f ? -1.0f : 1.0f;
+        normal = {axis == 0 ? sign : 0.0f, axis == 1 ? sign : 0.0f, axis == 2 ? sign : 0.0f};
+    }
+
+    // Lambert shading from a fixed key light; no shadow rays, so a pixel depends only on what it sees
+    static const vec3 kLightDirection = vec3{-0.4f, 0.8f, 0.6f}.normalized();
+    float diffuse = std::max(0.0f, normal.dot(kLightDirection));
+    return p.color_ * (kAmbient + (1.0f - kAmbient) * diffuse);
+}
+
+void sceneRenderer::tileRect(const renderSettings& settings, size_t tileIndex, int& outX0, int& outY0, int& outX1,
+                             int& outY1)
+{
+    size_t tilesX = (settings.width_ + kTileSize - 1) / kTileSize;
+    outX0 = static_cast<int>(tileIndex % tilesX) * kTileSize;
+    outY0 = static_cast<int>(tileIndex / tilesX) * kTileSize;
+    outX1 = std::min(outX0 + kTileSize, settings.width_);
+    outY1 = std::min(outY0 + kTileSize, settings.height_);
+}
+
+renderTileUpdate sceneRenderer::copyTile(const renderSettings& settings, size_t tileIndex,
+                                         const std::vector<uint8_t>& framebuffer)
+{
+    renderTileUpdate update;
+    int x1;
+    int y1;
+    tileRect(settings, tileIndex, update.x_, update.y_, x1, y1);
+    update.width_ = x1 - update.x_;
+    update.height_ = y1 - update.y_;
+    update.pixels_.reserve(static_cast<size_t>(update.width_) * update.height_ * 3);
+    for (int y = update.y_; y < y1; ++y)
+    {
+        auto row = framebuffer.begin() + (static_cast<size_t>(y) * settings.width_ + update.x_) * 3;
+        update.pixels_.insert(update.pixels_.end(), row, row + update.width_ * 3);
+    }
+    return update;
+}
+
+void sceneRenderer::renderTile(const camera& cam, const sceneIndex& index, const renderSettings& settings,
+                               size_t tileIndex, std::vector<uint8_t>& framebuffer) const
+{
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+    tileRect(settings, tileIndex, x0, y0, x1, y1);
+    float inverseSamples = 1.0f / static_cast<float>(settings.samplesPerPixel_);
+
+    rayPacket packet;
+    for (int y = y0; y < y1; ++y)
+    {
+        // Each packet covers a run of eight pixels in the row
+        for (int x = x0; x < x1; x += rayPacket::kWidth)
+        {
+            int lanes = std::min(rayPacket::kWidth, x1 - x);
+            vec3 color[rayPacket::kWidth];
+            for (int s = 0; s < settings.samplesPerPixel_; ++s)
+            {
+                for (int lane = 0; lane < rayPacket::kWidth; ++lane)
+                {
+                    // One sample goes through the pixel centre; extra samples are jittered inside the pixel
+                    float jx = 0.5f;
+                    float jy = 0.5f;
+                    if (settings.samplesPerPixel_ > 1)
+                    {
+                        uint32_t h = hashPixel(x + lane, y, s);
+                        jx = (h & 0xffff) / 65536.0f;
+                        jy = (h >> 16) / 65536.0f;
+                    }
+                    float u = (2.0f * (x + lane + jx) / settings.width_ - 1.0f) * cam.aspect_ * cam.tanHalfFov_;
+                    float v = (1.0f - 2.0f * (y + jy) / settings.height_) * cam.tanHalfFov_;
+                    vec3 direction = (cam.forward_ + cam.right_ * u + cam.up_ * v).normalized();
+                    packet.originX_[lane] = cam.origin_.x_;
+                    packet.originY_[lane] = cam.origin_.y_;
+                    packet.originZ_[lane] = cam.origin_.z_;
+                    packet.directionX_[lane] = direction.x_;
+                    packet.directionY_[lane] = direction.y_;
+                    packet.directionZ_[lane] = direction.z_;
+                    packet.distance_[lane] = lane < lanes ? std::numeric_limits<float>::infinity() : 0.0f;
+                }
+                index.intersect(packet, kernels_);
+
+                for (int lane = 0; lane < lanes; ++lane)
+                {
+                    color[lane] = color[lane] + shade(packet, lane, index);
+                }
+            }
+
+            // Gamma 2.2 for display
+            for (int lane = 0; lane < lanes; ++lane)
+            {
+                size_t offset = (static_cast<size_t>(y) * settings.width_ + x + lane) * 3;
+                for (int c = 0; c < 3; ++c)
+                {
+                    float linear = std::min(1.0f, std::max(0.0f, color[lane][c] * inverseSamples));
+                    float value = std::pow(linear, 1.0f / 2.2f);
+                    framebuffer[offset + c] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+                }
+            }
+        }
+    }
+}
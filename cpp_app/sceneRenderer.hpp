@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "imageEncoder.hpp"
+#include "rayPacketKernels.hpp"
+#include "softwareCore.hpp"
+#include "vec3.hpp"
+
+class sceneIndex;
+class sharedFramebuffer;
+class threadPool;
+
+// One finished tile, handed to renderSettings::tileSink_ for progressive display
+struct renderTileUpdate
+{
+    int x_ = 0;
+    int y_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<uint8_t> pixels_;  // RGB8, width_ * 3 bytes per row
+    size_t tilesDone_ = 0;
+    size_t tileCount_ = 0;
+};
+
+// Render parameters, parsed from the execute_software_command params
+struct renderSettings
+{
+    int width_ = 640;
+    int height_ = 480;
+    int samplesPerPixel_ = 1;
+    float fieldOfView_ = 60.0f;  // Vertical, in degrees
+    std::string cameraId_;       // Empty picks the first camera in the scene
+    std::string outputFile_ = "render_output.png";
+    imageEncoder::format format_ = imageEncoder::format::png;
+    bool incremental_ = true;  // Reuse unaffected tiles of the previous frame when only objects changed
+    std::string sharedMemoryName_;  // Non-empty publishes raw pixels to this segment instead of writing a file
+
+    // Optional; called from the worker threads as tiles finish. Returning false stops the render.
+    std::function<bool(const renderTileUpdate&)> tileSink_;
+};
+
+struct renderResult
+{
+    std::string outputFile_;
+    std::string cameraId_;
+    int width_ = 0;
+    int height_ = 0;
+    int samplesPerPixel_ = 0;
+    size_t tiles_ = 0;
+    size_t tilesTraced_ = 0;  // Fewer than tiles_ when the previous frame was reused
+    double renderMilliseconds_ = 0.0;
+    std::string simdLevel_;
+    bool cacheHit_ = false;
+    std::shared_ptr<const std::string> image_;  // Encoded image, shared with the render cache
+    std::string sharedMemoryName_;
+    uint64_t frame_ = 0;  // Frame number published to the shared-memory segment
+};
+
+// CPU ray tracer - splits the image into tiles and traces them on a work-stealing pool,
+// eight primary rays at a time through the scene's BVH and the packet kernels. The last frame of each
+// camera is kept so a render from the same view only re-traces tiles touched by objects that changed.
+class sceneRenderer
+{
+  public:
+    explicit sceneRenderer(threadPool& pool);
+    ~sceneRenderer();
+
+    static bool parseSettings(const std::map<std::string, std::string>& params, renderSettings& outSettings,
+                              std::string& outError);
+
+    // The index must have been built from the same snapshot. Progress is reported per finished tile;
+    // when it returns false the remaining tiles are skipped and no image is written.
+    bool render(const softwareCore::sceneSnapshot& scene, const sceneIndex& index, const renderSettings& settings,
+                renderResult& outResult, std::string& outError,
+                const softwareCore::progressCallback& progress = nullptr);
+
+    // Renders several views of the same snapshot, e.g. one per camera, with the tiles of all views traced
+    // in one parallel pass over the shared index. Progress covers all views together.
+    bool renderViews(const softwareCore::sceneSnapshot& scene, const sceneIndex& index,
+                     const std::vector<renderSettings>& views, std::vector<renderResult>& outResults,
+                     std::string& outError, const softwareCore::progressCallback& progress = nullptr);
+
+    softwareCore::frameFootprint measureMemory();
+
+  private:
+    struct camera
+    {
+        vec3 origin_;
+        vec3 forward_;
+        vec3 right_;
+        vec3 up_;
+        float tanHalfFov_;
+        float aspect_;
+    };
+
+    // Finished image with what it was rendered from
+    struct frame
+    {
+        int width_;
+        int height_;
+        int samplesPerPixel_;
+        camera camera_;
+        std::shared_ptr<const softwareCore::objectTable> objects_;
+        std::vector<uint8_t> pixels_;
+    };
+
+    static constexpr int kTileSize = 32;
+
+    threadPool& pool_;
+    const rayPacketKernels::kernelTable& kernels_;
+    std::mutex frameMutex_;
+    std::map<std::string, std::shared_ptr<const frame>> lastFrames_;  // By camera ID; empty for the default view
+    std::mutex sharedOutputMutex_;
+    std::map<std::string, std::unique_ptr<sharedFramebuffer>> sharedOutputs_;  // By segment name
+
+    static bool findCamera(const softwareCore::objectTable& objects, const renderSettings& settings,
+                           camera& outCamera, std::string& outCameraId, std::string& outError);
+    static bool sameView(const frame& previous, const renderSettings& settings, const camera& cam);
+    static void markChangedTiles(const softwareCore::objectTable& before, const softwareCore::objectTable& after,
+                                 const camera& cam, const renderSettings& settings, std::vector<char>& dirtyTiles);
+    static void markTiles(const aabb& bounds, const camera& cam, const renderSettings& settings,
+                          std::vector<char>& dirtyTiles);
+    sharedFramebuffer& sharedOutput(const std::string& name);
+    static vec3 shade(const rayPacket& packet, int lane, const sceneIndex& index);
+    void renderTile(const camera& cam, const sceneIndex& index, const renderSettings& settings, size_t tileIndex,
+                    std::vector<uint8_t>& framebuffer) const;
+    static renderTileUpdate copyTile(const renderSettings& settings, size_t tileIndex,
+                                     const std::vector<uint8_t>& framebuffer);
+    static void tileRect(const renderSettings& settings, size_t tileIndex, int& outX0, int& outY0, int& outX1,
+                         int& outY1);
+};
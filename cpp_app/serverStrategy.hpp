@@ -11,6 +11,12 @@ class serverStrategy
     // Start the server (blocking call)
     virtual void start() = 0;
 
+    // Access for startup configuration before start()
+    commandHandler& getHandler()
+    {
+        return handler_;
+    }
+
   protected:
     commandHandler handler_;  // Shared command handler for all server strategies
 };
@@ -0,0 +1,150 @@
+#include "sharedFramebuffer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+constexpr uint32_t kDataOffset = 64;  // Keeps the pixels cache-line aligned after the header
+constexpr uint32_t kChannels = 3;
+static_assert(sizeof(sharedFramebuffer::header) <= kDataOffset, "header must fit before the pixel data");
+}  // namespace
+
+sharedFramebuffer::sharedFramebuffer(const std::string& name)
+    : name_(name), fd_(-1), mapping_(nullptr), mappedBytes_(0)
+{
+}
+
+sharedFramebuffer::~sharedFramebuffer()
+{
+    unmap();
+#ifndef _WIN32
+    if (fd_ >= 0)
+    {
+        close(fd_);
+        shm_unlink(name_.c_str());
+    }
+#endif
+}
+
+bool sharedFramebuffer::validName(const std::string& name)
+{
+    return name.size() > 1 && name.size() < 256 && name[0] == '/' && name.find('/', 1) == std::string::npos;
+}
+
+bool sharedFramebuffer::publish(int width, int height, const std::vector<uint8_t>& rgb, uint64_t& outFrame,
+                                std::string& outError)
+{
+    size_t dataBytes = static_cast<size_t>(width) * height * kChannels;
+    if (rgb.size() != dataBytes)
+    {
+        outError = "Framebuffer size does not match the image";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!reserve(dataBytes, outError))
+    {
+        return false;
+    }
+
+    // Seqlock write: readers retry while the sequence is odd or changed during their copy
+    header* h = static_cast<header*>(mapping_);
+    uint64_t sequence = h->sequence_.load(std::memory_order_relaxed);
+    h->sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    h->width_ = static_cast<uint32_t>(width);
+    h->height_ = static_cast<uint32_t>(height);
+    h->channels_ = kChannels;
+    h->dataOffset_ = kDataOffset;
+    h->dataBytes_ = dataBytes;
+    std::memcpy(static_cast<uint8_t*>(mapping_) + kDataOffset, rgb.data(), dataBytes);
+    h->sequence_.store(sequence + 2, std::memory_order_release);
+
+    outFrame = (sequence + 2) / 2;
+    return true;
+}
+
+bool sharedFramebuffer::reserve(size_t dataBytes, std::string& outError)
+{
+#ifdef _WIN32
+    (void)dataBytes;
+    outError = "Shared-memory output needs POSIX shared memory, which this platform does not provide";
+    return false;
+#else
+    if (mapping_ && mappedBytes_ - kDataOffset >= dataBytes)
+    {
+        return true;
+    }
+
+    bool created = fd_ < 0;
+    if (created)
+    {
+        fd_ = shm_open(name_.c_str(), O_CREAT | O_RDWR, 0644);
+        if (fd_ < 0)
+        {
+            outError = "Could not open shared memory segment " + name_ + ": " + std::strerror(errno);
+            return false;
+        }
+    }
+
+    // A segment left by an earlier run may already be larger; keep its size so its readers stay valid
+    struct stat info;
+    if (fstat(fd_, &info) != 0)
+    {
+        outError = "Could not stat shared memory segment " + name_ + ": " + std::strerror(errno);
+        return false;
+    }
+    size_t bytes = std::max(static_cast<size_t>(info.st_size), kDataOffset + dataBytes);
+    if (static_cast<size_t>(info.st_size) < bytes && ftruncate(fd_, static_cast<off_t>(bytes)) != 0)
+    {
+        outError = "Could not size shared memory segment " + name_ + ": " + std::strerror(errno);
+        return false;
+    }
+
+    unmap();
+    void* mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapping == MAP_FAILED)
+    {
+        outError = "Could not map shared memory segment " + name_ + ": " + std::strerror(errno);
+        return false;
+    }
+    mapping_ = mapping;
+    mappedBytes_ = bytes;
+
+    // Continue the frame numbering of a segment this server published to before, so readers never see it go back
+    header* h = static_cast<header*>(mapping_);
+    if (created && (h->magic_ != kMagic || h->version_ != kVersion))
+    {
+        std::memset(mapping_, 0, kDataOffset);
+        h->magic_ = kMagic;
+        h->version_ = kVersion;
+    }
+    else if (created)
+    {
+        uint64_t sequence = h->sequence_.load(std::memory_order_relaxed);
+        h->sequence_.store(sequence + (sequence & 1), std::memory_order_relaxed);  // Writer died mid-frame
+    }
+    h->capacity_ = bytes - kDataOffset;
+    return true;
+#endif
+}
+
+void sharedFramebuffer::unmap()
+{
+#ifndef _WIN32
+    if (mapping_)
+    {
+        munmap(mapping_, mappedBytes_);
+    }
+#endif
+    mapping_ = nullptr;
+    mappedBytes_ = 0;
+}
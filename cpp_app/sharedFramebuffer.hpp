@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Named POSIX shared-memory segment holding the latest frame as raw RGB8. Each publish bumps a sequence
+// number around the pixel copy (odd while writing), so co-located readers can map the segment once and
+// take consistent frames without locks, copies through the server or disk I/O.
+class sharedFramebuffer
+{
+  public:
+    static constexpr uint32_t kMagic = 0x42465043;  // "CPFB" little-endian
+    static constexpr uint32_t kVersion = 1;
+
+    // Segment layout: this header, then height_ rows of width_ * channels_ bytes at dataOffset_
+    struct header
+    {
+        uint32_t magic_;
+        uint32_t version_;
+        std::atomic<uint64_t> sequence_;  // Odd while a frame is being written; the frame number is sequence_ / 2
+        uint32_t width_;
+        uint32_t height_;
+        uint32_t channels_;
+        uint32_t dataOffset_;
+        uint64_t dataBytes_;
+        uint64_t capacity_;  // Pixel bytes the segment can hold; grows, never shrinks
+    };
+
+    explicit sharedFramebuffer(const std::string& name);
+    ~sharedFramebuffer();
+
+    sharedFramebuffer(const sharedFramebuffer&) = delete;
+    sharedFramebuffer& operator=(const sharedFramebuffer&) = delete;
+
+    // Copies the frame into the segment, creating or growing it as needed
+    bool publish(int width, int height, const std::vector<uint8_t>& rgb, uint64_t& outFrame, std::string& outError);
+
+    // POSIX names: a leading '/', then up to 254 characters other than '/'
+    static bool validName(const std::string& name);
+
+  private:
+    std::string name_;
+    std::mutex mutex_;
+    int fd_;
+    void* mapping_;
+    size_t mappedBytes_;
+
+    bool reserve(size_t dataBytes, std::string& outError);  // Caller must hold mutex_
+    void unmap();
+};
@@ -0,0 +1,118 @@
+#include "slowRequestLog.hpp"
+#include "nlohmann/json.hpp"
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+const char* requestPhases::phaseName(size_t index)
+{
+    static const char* const names[kPhases] = {"read", "parse", "dispatch_wait", "execute", "serialize", "send"};
+    return index < kPhases ? names[index] : "unknown";
+}
+
+slowRequestLog::slowRequestLog() : enabled_(false), thresholdNanoseconds_(0), dropped_(0), stopping_(false)
+{
+}
+
+slowRequestLog::~slowRequestLog()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (writer_.joinable())
+    {
+        writer_.join();
+    }
+}
+
+bool slowRequestLog::open(const std::string& path, std::chrono::microseconds threshold)
+{
+    if (writer_.joinable())
+    {
+        return false;  // Already logging
+    }
+    file_.open(path, std::ios::app);
+    if (!file_.is_open())
+    {
+        return false;
+    }
+    thresholdNanoseconds_ = static_cast<uint64_t>(threshold.count()) * 1000;
+    writer_ = std::thread(&slowRequestLog::writerLoop, this);
+    enabled_.store(true, std::memory_order_release);
+    return true;
+}
+
+void slowRequestLog::record(const char* transport, std::string_view command, const requestPhases& phases)
+{
+    if (!enabled_.load(std::memory_order_relaxed) ||
+        phases.totalNanoseconds() < thresholdNanoseconds_.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.size() >= kMaxPending)
+        {
+            ++dropped_;
+            return;
+        }
+        pending_.push_back(
+            {std::chrono::system_clock::now(), transport, std::string(command), phases.totalNanoseconds(),
+             phases.nanoseconds()});
+    }
+    cv_.notify_one();
+}
+
+void slowRequestLog::writerLoop()
+{
+    while (true)
+    {
+        std::deque<entry> batch;
+        uint64_t dropped = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+            if (pending_.empty())
+            {
+                return;
+            }
+            batch.swap(pending_);
+            std::swap(dropped, dropped_);
+        }
+
+        // Formatting and I/O happen here, off the request threads
+        for (const entry& e : batch)
+        {
+            std::time_t seconds = std::chrono::system_clock::to_time_t(e.time_);
+            std::tm utc{};
+#ifdef _WIN32
+            gmtime_s(&utc, &seconds);
+#else
+            gmtime_r(&seconds, &utc);
+#endif
+            std::ostringstream time;
+            time << std::put_time(&utc, "%Y-%m-%dT%H:%M:%SZ");
+
+            nlohmann::json phases = nlohmann::json::object();
+            for (size_t i = 0; i < requestPhases::kPhases; ++i)
+            {
+                phases[requestPhases::phaseName(i)] = e.phaseNanoseconds_[i] / 1e6;
+            }
+            nlohmann::json line = {{"time", time.str()},
+                                   {"transport", e.transport_},
+                                   {"command", e.command_},
+                                   {"total_ms", e.totalNanoseconds_ / 1e6},
+                                   {"phases_ms", phases}};
+            if (dropped > 0)
+            {
+                line["dropped_before"] = dropped;
+                dropped = 0;
+            }
+            file_ << line.dump() << '\n';
+        }
+        file_.flush();
+    }
+}
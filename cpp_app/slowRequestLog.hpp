@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Time spent in each phase of one request. mark() closes the phase that just finished, so the phases add up
+// to the request's total time; phases a transport does not see stay zero.
+class requestPhases
+{
+  public:
+    enum class phase
+    {
+        read,          // Accept to the end of reading the request
+        parse,         // JSON parse
+        dispatchWait,  // Waiting for the handler table lock
+        execute,       // Command handler
+        serialize,     // Response to JSON text
+        send           // Writing the response
+    };
+    static constexpr size_t kPhases = 6;
+
+    explicit requestPhases(std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now())
+        : start_(start), last_(start), nanoseconds_{}
+    {
+    }
+
+    void mark(phase finished)
+    {
+        auto now = std::chrono::steady_clock::now();
+        nanoseconds_[static_cast<size_t>(finished)] +=
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_).count());
+        last_ = now;
+    }
+
+    uint64_t totalNanoseconds() const
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(last_ - start_).count());
+    }
+
+    const std::array<uint64_t, kPhases>& nanoseconds() const
+    {
+        return nanoseconds_;
+    }
+
+    static const char* phaseName(size_t index);
+
+  private:
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point last_;
+    std::array<uint64_t, kPhases> nanoseconds_;
+};
+
+// Requests slower than a threshold, appended to a file as JSON lines by a background thread. Recording
+// only queues the entry; when the writer falls behind, entries beyond kMaxPending are dropped and counted.
+class slowRequestLog
+{
+  public:
+    static constexpr size_t kMaxPending = 1024;
+
+    slowRequestLog();
+    ~slowRequestLog();
+
+    // Starts logging; until then record() is a single relaxed load
+    bool open(const std::string& path, std::chrono::microseconds threshold);
+
+    void record(const char* transport, std::string_view command, const requestPhases& phases);
+
+  private:
+    struct entry
+    {
+        std::chrono::system_clock::time_point time_;
+        const char* transport_;
+        std::string command_;
+        uint64_t totalNanoseconds_;
+        std::array<uint64_t, requestPhases::kPhases> phaseNanoseconds_;
+    };
+
+    std::atomic<bool> enabled_;
+    std::atomic<uint64_t> thresholdNanoseconds_;
+    std::ofstream file_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<entry> pending_;
+    uint64_t dropped_;  // Since the last written entry
+    bool stopping_;
+    std::thread writer_;
+
+    void writerLoop();
+};
@@ -1,5 +1,8 @@
 #include "socketServerStrategy.hpp"
-#include <iostream>
+#include "logger.hpp"
+#include "traceRecorder.hpp"
+#include <cerrno>
+#include <chrono>
 #include <sstream>
 #include <stdexcept>
 
@@ -45,7 +48,7 @@ void socketServerStrategy::start()
 {
     if (running_)
     {
-        std::cout << "Socket server is already running" << std::endl;
+        logger::warn("socket", "Socket server is already running");
         return;
     }
 
@@ -53,7 +56,7 @@ void socketServerStrategy::start()
     {
         running_ = true;
 
-        std::cout << "Starting Socket Server on port " << port_ << "..." << std::endl;
+        logger::info("socket", "Starting socket server", {{"port", port_}});
 
         // Start server in a separate thread initially, then join to make it blocking
         server_thread_ = std::thread(&socketServerStrategy::serverLoop, this);
@@ -72,8 +75,9 @@ void socketServerStrategy::registerHandlers()
     auto registerHandler = [this](const std::string& command, auto memberFunc)
     {
         std::lock_guard<std::mutex> lock(handlers_mutex_);
-        command_handlers_[command] = [this, memberFunc](const nlohmann::json& params)
-        { return (handler_.*memberFunc)(params); };
+        command_handlers_[command] = {[this, memberFunc](const nlohmann::json& params)
+                                      { return (handler_.*memberFunc)(params); },
+                                      &handler_.metrics().statsFor(runtimeMetrics::transport::socket, command)};
     };
 
     // Register all command handlers
@@ -81,11 +85,22 @@ void socketServerStrategy::registerHandlers()
     registerHandler("get_software_status", &commandHandler::getSoftwareStatus);
     registerHandler("create_object", &commandHandler::createObject);
     registerHandler("delete_object", &commandHandler::deleteObject);
+    registerHandler("update_object", &commandHandler::updateObject);
     registerHandler("list_objects", &commandHandler::listObjects);
     registerHandler("get_object_info", &commandHandler::getObjectInfo);
     registerHandler("execute_software_command", &commandHandler::executeSoftwareCommand);
     registerHandler("save_project", &commandHandler::saveProject);
     registerHandler("load_project", &commandHandler::loadProject);
+    registerHandler("get_job_status", &commandHandler::getJobStatus);
+    registerHandler("cancel_job", &commandHandler::cancelJob);
+    registerHandler("query_region", &commandHandler::queryRegion);
+    registerHandler("raycast", &commandHandler::raycast);
+    registerHandler("get_metrics", &commandHandler::getMetrics);
+    registerHandler("trace_start", &commandHandler::traceStart);
+    registerHandler("trace_stop", &commandHandler::traceStop);
+    registerHandler("profile_start", &commandHandler::profileStart);
+    registerHandler("profile_stop", &commandHandler::profileStop);
+    registerHandler("memory_report", &commandHandler::memoryReport);
 }
 
 void socketServerStrategy::serverLoop()
@@ -121,7 +136,7 @@ void socketServerStrategy::serverLoop()
         throw std::runtime_error("Failed to listen on socket");
     }
 
-    std::cout << "Socket server listening on port " << port_ << std::endl;
+    logger::info("socket", "Socket server listening", {{"port", port_}});
 
     while (running_)
     {
@@ -131,54 +146,103 @@ void socketServerStrategy::serverLoop()
 
         if (client_socket != INVALID_SOCKET)
         {
-            std::thread(&socketServerStrategy::handleClient, this, client_socket).detach();
+            std::thread(&socketServerStrategy::handleClient, this, client_socket, std::chrono::steady_clock::now())
+                .detach();
         }
         else if (running_)
         {
-            std::cerr << "Failed to accept client connection" << std::endl;
+#ifdef _WIN32
+            logger::warn("socket", "Failed to accept client connection", {{"error", WSAGetLastError()}});
+#else
+            logger::warn("socket", "Failed to accept client connection", {{"errno", errno}});
+#endif
         }
     }
 
     closesocket(server_socket);
 }
 
-void socketServerStrategy::handleClient(socket_t client_socket)
+void socketServerStrategy::handleClient(socket_t client_socket, std::chrono::steady_clock::time_point accepted)
 {
+    traceRecorder::setThreadName("socket client");
+    traceSpan requestSpan("socket.request", "socket");
+    requestPhases phases(accepted);
+    std::string command;
+    runtimeMetrics& metrics = handler_.metrics();
+    metrics.add(runtimeMetrics::counter::connectionsAccepted);
+    metrics.connectionOpened();
     try
     {
         char buffer[4096];
+        traceSpan readSpan("socket.read", "socket");
         int bytes_received = recv(client_socket, buffer, sizeof(buffer) - 1, 0);
+        readSpan.end();
 
         if (bytes_received > 0)
         {
+            phases.mark(requestPhases::phase::read);
             buffer[bytes_received] = '\0';
             std::string request_str(buffer);
 
             try
             {
+                traceSpan parseSpan("socket.parse", "socket");
                 nlohmann::json request = nlohmann::json::parse(request_str);
-                nlohmann::json response = processCommand(request);
+                parseSpan.end();
+                phases.mark(requestPhases::phase::parse);
+                if (request.contains("command") && request["command"].is_string())
+                {
+                    command = request["command"].get<std::string>();
+                }
+                nlohmann::json response = processCommand(request, phases);
 
+                traceSpan serializeSpan("socket.serialize", "socket");
                 std::string response_str = response.dump();
+                serializeSpan.end();
+                phases.mark(requestPhases::phase::serialize);
+                traceSpan sendSpan("socket.send", "socket");
                 send(client_socket, response_str.c_str(), static_cast<int>(response_str.length()), 0);
+                sendSpan.end();
+                phases.mark(requestPhases::phase::send);
             }
             catch (const std::exception& e)
             {
+                // Timed like a normal reply, so a request that fails slowly still counts in full
+                traceSpan serializeSpan("socket.serialize", "socket");
                 nlohmann::json error_response = {{"error", "Invalid JSON or processing error"}, {"message", e.what()}};
                 std::string response_str = error_response.dump();
+                serializeSpan.end();
+                phases.mark(requestPhases::phase::serialize);
+                traceSpan sendSpan("socket.send", "socket");
                 send(client_socket, response_str.c_str(), static_cast<int>(response_str.length()), 0);
+                sendSpan.end();
+                phases.mark(requestPhases::phase::send);
             }
         }
     }
     catch (const std::exception& e)
     {
-        std::cerr << "Error handling client: " << e.what() << std::endl;
+        logger::error("socket", "Error handling client", {{"command", command}, {"error", e.what()}});
     }
 
+    requestSpan.end();  // Before the close, which is when the client sees the response complete
     closesocket(client_socket);
+    metrics.connectionClosed();
+    handler_.slowLog().record("socket", command, phases);
+}
+
+nlohmann::json socketServerStrategy::processCommand(const nlohmann::json& request, requestPhases& phases)
+{
+    handler_.metrics().add(runtimeMetrics::counter::socketRequests);
+    nlohmann::json response = dispatch(request, phases);
+    if (response.contains("error"))
+    {
+        handler_.metrics().add(runtimeMetrics::counter::failedRequests);
+    }
+    return response;
 }
 
-nlohmann::json socketServerStrategy::processCommand(const nlohmann::json& request)
+nlohmann::json socketServerStrategy::dispatch(const nlohmann::json& request, requestPhases& phases)
 {
     if (!request.contains("command"))
     {
@@ -188,18 +252,31 @@ nlohmann::json socketServerStrategy::processCommand(const nlohmann::json& reques
     std::string command = request["command"];
     nlohmann::json params = request.value("params", nlohmann::json::object());
 
+    traceSpan waitSpan("socket.dispatch_wait", "socket");
     std::lock_guard<std::mutex> lock(handlers_mutex_);
+    waitSpan.end();
+    phases.mark(requestPhases::phase::dispatchWait);
     auto it = command_handlers_.find(command);
     if (it != command_handlers_.end())
     {
+        perfCounters::sample countersBefore = perfCounters::read();
+        allocationTracker::sample allocationsBefore = allocationTracker::read();
+        auto start = std::chrono::steady_clock::now();
+        nlohmann::json response;
         try
         {
-            return it->second(params);
+            response = it->second.handler_(params);
         }
         catch (const std::exception& e)
         {
-            return {{"error", "Command execution failed"}, {"message", e.what()}};
+            response = {{"error", "Command execution failed"}, {"message", e.what()}};
         }
+        it->second.stats_->latency_.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+        it->second.stats_->allocations_.add(allocationsBefore, allocationTracker::read());
+        it->second.stats_->counters_.add(countersBefore, perfCounters::read());
+        phases.mark(requestPhases::phase::execute);
+        return response;
     }
     else
     {
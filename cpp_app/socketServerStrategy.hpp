@@ -3,6 +3,7 @@
 #include "nlohmann/json.hpp"
 #include "serverStrategy.hpp"
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <map>
 #include <mutex>
@@ -30,12 +31,18 @@ class socketServerStrategy : public serverStrategy
     std::atomic<bool> running_;
     std::thread server_thread_;
     std::mutex handlers_mutex_;
-    std::map<std::string, std::function<nlohmann::json(const nlohmann::json&)>> command_handlers_;
+    struct commandEntry
+    {
+        std::function<nlohmann::json(const nlohmann::json&)> handler_;
+        runtimeMetrics::commandStats* stats_;  // Owned by the handler's metrics
+    };
+    std::map<std::string, commandEntry> command_handlers_;
 
     void registerHandlers();
     void serverLoop();
-    void handleClient(socket_t client_socket);
-    nlohmann::json processCommand(const nlohmann::json& request);
+    void handleClient(socket_t client_socket, std::chrono::steady_clock::time_point accepted);
+    nlohmann::json processCommand(const nlohmann::json& request, requestPhases& phases);
+    nlohmann::json dispatch(const nlohmann::json& request, requestPhases& phases);
 
 #ifdef _WIN32
     static void initializeWinsock();
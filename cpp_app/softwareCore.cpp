@@ -1,19 +1,55 @@
 #include "softwareCore.hpp"
 #include "nlohmann/json.hpp"
-#include <fstream>
+#include "imageEncoder.hpp"
+#include "logger.hpp"
+#include "memoryFootprint.hpp"
+#include "projectSerializer.hpp"
+#include "renderCache.hpp"
+#include "sceneIndex.hpp"
+#include "sceneRenderer.hpp"
+#include "threadPool.hpp"
+#include "traceRecorder.hpp"
+#include <algorithm>
+#include <chrono>
 #include <iomanip>
+#include <mutex>
 #include <random>
 #include <sstream>
+#include <stdexcept>
+
+namespace
+{
+// Delta segments accumulated on one checkpoint before a delta save is promoted to a full rewrite
+constexpr size_t kCompactionThreshold = 8;
+// Objects measured between progress reports and cancellation checks
+constexpr size_t kMeasureProgressInterval = 4096;
+}  // namespace
 
 softwareCore::softwareCore()
-    : currentProject_("untitled_project"), isRunning_(true), softwareName_("My Example Software"), version_("1.0.0")
+    : objects_(std::make_shared<objectTable>()),
+      contentHash_(0),
+      currentProject_("untitled_project"),
+      isRunning_(true),
+      softwareName_("My Example Software"),
+      version_("1.0.0"),
+      deltaSegments_(0),
+      checkpointEpoch_(0),
+      nextSaveTicket_(0),
+      saveTurn_(0),
+      workers_(std::make_unique<threadPool>()),
+      renderer_(std::make_unique<sceneRenderer>(*workers_)),
+      renderCache_(std::make_unique<renderCache>()),
+      indexStale_(true)
 {
     initializeDefaultObjects();
 }
 
+softwareCore::~softwareCore() = default;
+
 softwareCore::softwareInfo softwareCore::getSoftwareInfo() const
 {
-    return {softwareName_, version_, isRunning_, currentProject_, objects_.size()};
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return {softwareName_, version_, isRunning_, currentProject_, objects_->size()};
 }
 
 softwareCore::softwareInfo softwareCore::getSoftwareStatus() const
@@ -24,75 +60,133 @@ softwareCore::softwareInfo softwareCore::getSoftwareStatus() const
 std::string softwareCore::createObject(const std::string& name, const std::string& type,
                                        const std::map<std::string, std::string>& properties)
 {
+    traceSpan span("softwareCore::createObject", "core");
     if (!validateObjectType(type))
     {
         return "";  // Invalid type
     }
 
     std::string id = generateObjectId();
-    softwareObject obj;
-    obj.name_ = name;
-    obj.type_ = type;
-    obj.properties_ = properties;
-    obj.properties_["created_at"] = "now";
-    obj.properties_["id"] = id;
+    auto obj = std::make_shared<softwareObject>();
+    obj->name_ = name;
+    obj->type_ = type;
+    obj->properties_ = properties;
+    obj->properties_["created_at"] = "now";
+    obj->properties_["id"] = id;
 
     // Add type-specific default properties
-    if (type == "cube" && obj.properties_.find("size") == obj.properties_.end())
+    if (type == "cube" && obj->properties_.find("size") == obj->properties_.end())
     {
-        obj.properties_["size"] = "1.0";
+        obj->properties_["size"] = "1.0";
     }
-    if (type == "sphere" && obj.properties_.find("radius") == obj.properties_.end())
+    if (type == "sphere" && obj->properties_.find("radius") == obj->properties_.end())
     {
-        obj.properties_["radius"] = "0.5";
+        obj->properties_["radius"] = "0.5";
     }
-    if ((type == "cube" || type == "sphere") && obj.properties_.find("color") == obj.properties_.end())
+    if ((type == "cube" || type == "sphere") && obj->properties_.find("color") == obj->properties_.end())
     {
-        obj.properties_["color"] = "white";
+        obj->properties_["color"] = "white";
     }
     if (type == "camera")
     {
-        if (obj.properties_.find("position") == obj.properties_.end())
+        if (obj->properties_.find("position") == obj->properties_.end())
         {
-            obj.properties_["position"] = "0,0,5";
+            obj->properties_["position"] = "0,0,5";
         }
-        if (obj.properties_.find("rotation") == obj.properties_.end())
+        if (obj->properties_.find("rotation") == obj->properties_.end())
         {
-            obj.properties_["rotation"] = "0,0,0";
+            obj->properties_["rotation"] = "0,0,0";
         }
     }
 
-    objects_[id] = obj;
+    // Log the resulting state rather than the request so replay is deterministic
+    std::string record =
+        nlohmann::json{{"op", "create"}, {"id", id}, {"object", projectSerializer::objectToJson(*obj)}}.dump();
+    uint64_t lsn;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        storeObject(id, std::move(obj));
+        dirtyObjects_.insert(id);
+        indexChanges_.insert(id);
+        lsn = logMutation(record);
+    }
+    waitForLog(lsn);
     return id;
 }
 
 bool softwareCore::deleteObject(const std::string& objectId)
 {
-    auto it = objects_.find(objectId);
-    if (it != objects_.end())
+    traceSpan span("softwareCore::deleteObject", "core");
+    uint64_t lsn;
     {
-        objects_.erase(it);
-        return true;
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (objects_->find(objectId) == objects_->end())
+        {
+            return false;
+        }
+        storeObject(objectId, nullptr);
+        dirtyObjects_.erase(objectId);
+        deletedObjects_.insert(objectId);
+        indexChanges_.insert(objectId);
+        lsn = logMutation(nlohmann::json{{"op", "delete"}, {"id", objectId}}.dump());
     }
-    return false;
+    waitForLog(lsn);
+    return true;
+}
+
+bool softwareCore::updateObject(const std::string& objectId, const std::map<std::string, std::string>& properties)
+{
+    traceSpan span("softwareCore::updateObject", "core");
+    uint64_t lsn;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = objects_->find(objectId);
+        if (it == objects_->end())
+        {
+            return false;
+        }
+
+        auto obj = std::make_shared<softwareObject>(*it->second);
+        for (const auto& property : properties)
+        {
+            if (property.first != "id" && property.first != "created_at")
+            {
+                obj->properties_[property.first] = property.second;
+            }
+        }
+
+        std::string record = nlohmann::json{
+            {"op", "update"}, {"id", objectId}, {"object", projectSerializer::objectToJson(*obj)}}.dump();
+        storeObject(objectId, std::move(obj));
+        dirtyObjects_.insert(objectId);
+        indexChanges_.insert(objectId);
+        lsn = logMutation(record);
+    }
+    waitForLog(lsn);
+    return true;
 }
 
 std::vector<std::pair<std::string, softwareCore::softwareObject>> softwareCore::listObjects() const
 {
-    std::vector<std::pair<std::string, softwareObject>> result(objects_.size());
-    for (const auto& pair : objects_)
+    traceSpan span("softwareCore::listObjects", "core");
+    std::shared_ptr<const objectTable> objects = snapshot().objects_;
+    std::vector<std::pair<std::string, softwareObject>> result;
+    result.reserve(objects->size());
+    for (const auto& pair : *objects)
     {
-        result.emplace_back(pair.first, pair.second);
+        result.emplace_back(pair.first, *pair.second);
     }
     return result;
 }
 
 bool softwareCore::getObjectInfo(const std::string& objectId, softwareObject& outObject) const
 {
-    auto it = objects_.find(objectId);
-    if (it != objects_.end())
+    traceSpan span("softwareCore::getObjectInfo", "core");
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = objects_->find(objectId);
+    if (it != objects_->end())
     {
-        outObject = it->second;
+        outObject = *it->second;
         return true;
     }
     return false;
@@ -100,119 +194,600 @@ bool softwareCore::getObjectInfo(const std::string& objectId, softwareObject& ou
 
 bool softwareCore::saveProject(const std::string& filename)
 {
-    try
+    saveMode writtenMode;
+    return saveProject(filename, saveOptions(), writtenMode);
+}
+
+bool softwareCore::saveProject(const std::string& filename, const saveOptions& options, saveMode& outWrittenMode)
+{
+    std::shared_ptr<preparedSave> save = prepareSave(filename, options);
+    return saveProject(*save, options.progress_, outWrittenMode);
+}
+
+std::shared_ptr<softwareCore::preparedSave> softwareCore::prepareSave(const std::string& filename,
+                                                                      const saveOptions& options)
+{
+    traceSpan span("save.snapshot", "core");
+    auto save = std::make_shared<preparedSave>();
+    save->filename_ = filename;
+    save->options_ = options;
+
+    // Take the change sets with the snapshot; mutations from here on belong to the next save
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    save->core_ = this;
+    save->scene_ = {currentProject_, objects_, contentHash_};
+    save->dirty_.swap(dirtyObjects_);
+    save->deleted_.swap(deletedObjects_);
+    save->epoch_ = checkpointEpoch_;
+    save->coveredLsn_ = log_ ? log_->lastLsn() : 0;
+    save->ticket_ = nextSaveTicket_++;
+    return save;
+}
+
+bool softwareCore::saveProject(preparedSave& save, const progressCallback& progress, saveMode& outWrittenMode)
+{
+    traceSpan span("softwareCore::saveProject", "core");
+    traceSpan waitSpan("save.wait", "core");
     {
-        nlohmann::json project_data = {{"project_name", currentProject_}, {"objects", nlohmann::json::object()}};
+        std::unique_lock<std::mutex> turnLock(saveMutex_);
+        saveTurnCv_.wait(turnLock, [this, &save] { return saveTurn_ == save.ticket_; });
+    }
+    waitSpan.end();
 
-        for (const auto& pair : objects_)
+    // Decided now rather than at the snapshot, so a delta lands on whatever full save was written before it
+    const std::string& filename = save.filename_;
+    saveMode mode = save.options_.mode_;
+    std::string checkpointId;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        if (mode == saveMode::delta && (save.epoch_ != checkpointEpoch_ || filename != checkpointFile_ ||
+                                        checkpointId_.empty() || deltaSegments_ >= kCompactionThreshold))
         {
-            nlohmann::json obj_json = {
-                {"name", pair.second.name_}, {"type", pair.second.type_}, {"properties", nlohmann::json::object()}};
+            mode = saveMode::full;  // No usable base file, or time to compact the segments
+        }
+        checkpointId = mode == saveMode::full ? generateCheckpointId() : checkpointId_;
+    }
 
-            for (const auto& prop : pair.second.properties_)
-            {
-                obj_json["properties"][prop.first] = prop.second;
-            }
+    // Serialize outside the lock so writers are not blocked for the duration of the save.
+    // A cancelled save is treated like a failed one and leaves the changes pending.
+    bool saved = !progress || progress(0.1);
+    traceSpan writeSpan("save.write", "io");
+    if (saved && mode == saveMode::full)
+    {
+        saved = projectSerializer::writeProject(save.scene_, filename, checkpointId, save.options_.threads_,
+                                                save.options_.compress_);
+    }
+    else if (saved && (!save.dirty_.empty() || !save.deleted_.empty()))
+    {
+        saved = projectSerializer::appendDelta(save.scene_, save.dirty_, save.deleted_, filename, checkpointId);
+    }
 
-            project_data["objects"][pair.first] = obj_json;
-        }
+    writeSpan.end();
 
-        std::ofstream file(filename);
-        if (file.is_open())
+    // The file is synced and now holds everything logged up to the snapshot, so recovery can start from it
+    bool checkpointed = true;
+    if (saved && log_)
+    {
+        traceSpan checkpointSpan("save.checkpoint", "io");
+        checkpointed =
+            log_->checkpoint(save.coveredLsn_, nlohmann::json{{"op", "checkpoint"}, {"file", filename}}.dump());
+        if (!checkpointed)
         {
-            file << project_data.dump(4);
-            file.close();
-            return true;
+            logger::error("wal", "Checkpoint failed after save", {{"file", filename}});
         }
     }
-    catch (const std::exception&)
+    if (saved && progress)
     {
-        // Handle error
+        progress(0.9);
     }
-    return false;
-}
 
-bool softwareCore::loadProject(const std::string& filename)
-{
-    try
+    traceSpan commitSpan("save.commit", "core");
     {
-        std::ifstream file(filename);
-        if (file.is_open())
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        save.finished_ = true;
+        // After a load replaced the scene meanwhile, its checkpoint wins and this save leaves no trace
+        if (save.epoch_ == checkpointEpoch_)
         {
-            nlohmann::json project_data;
-            file >> project_data;
-            file.close();
-
-            // Clear existing objects
-            objects_.clear();
-
-            // Load objects from file
-            if (project_data.contains("objects"))
+            if (!saved)
             {
-                for (const auto& item : project_data["objects"].items())
-                {
-                    const std::string& id = item.key();
-                    const auto& obj_data = item.value();
-                    softwareObject obj;
-                    obj.name_ = obj_data.value("name", "");
-                    obj.type_ = obj_data.value("type", "");
-
-                    if (obj_data.contains("properties"))
-                    {
-                        for (const auto& prop_item : obj_data["properties"].items())
-                        {
-                            obj.properties_[prop_item.key()] = prop_item.value().get<std::string>();
-                        }
-                    }
-
-                    objects_[id] = obj;
-                }
+                // Keep the changes pending so the next save still covers them
+                dirtyObjects_.insert(save.dirty_.begin(), save.dirty_.end());
+                deletedObjects_.insert(save.deleted_.begin(), save.deleted_.end());
             }
-
-            // Update current project name
-            if (project_data.contains("project_name"))
+            else if (mode == saveMode::full)
+            {
+                checkpointFile_ = filename;
+                checkpointId_ = checkpointId;
+                deltaSegments_ = 0;
+                projectSerializer::removeDeltas(filename);
+            }
+            else if (!save.dirty_.empty() || !save.deleted_.empty())
             {
-                currentProject_ = project_data["project_name"];
+                ++deltaSegments_;
             }
+        }
+    }
+    releaseSaveTurn(save.ticket_);
+    outWrittenMode = mode;
+    // The file itself is complete, so its checkpoint is kept; only the log failed to record it
+    return saved && checkpointed;
+}
+
+softwareCore::preparedSave::~preparedSave()
+{
+    if (core_ && !finished_)
+    {
+        core_->abandonSave(*this);
+    }
+}
 
-            return true;
+void softwareCore::abandonSave(preparedSave& save)
+{
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        if (save.epoch_ == checkpointEpoch_)
+        {
+            dirtyObjects_.insert(save.dirty_.begin(), save.dirty_.end());
+            deletedObjects_.insert(save.deleted_.begin(), save.deleted_.end());
         }
     }
-    catch (const std::exception&)
+    // Never waits for its turn: this runs when a queued job is cancelled, before earlier saves have written
+    releaseSaveTurn(save.ticket_);
+}
+
+void softwareCore::releaseSaveTurn(uint64_t ticket)
+{
     {
-        // Handle error
+        std::lock_guard<std::mutex> turnLock(saveMutex_);
+        releasedSaves_.insert(ticket);
+        while (releasedSaves_.erase(saveTurn_) != 0)
+        {
+            ++saveTurn_;
+        }
     }
-    return false;
+    saveTurnCv_.notify_all();
+}
+
+bool softwareCore::loadProject(const std::string& filename, const progressCallback& progress)
+{
+    traceSpan span("softwareCore::loadProject", "core");
+    std::string projectName;
+    std::string checkpointId;
+    size_t deltaSegments = 0;
+    auto objects = std::make_shared<objectTable>();
+    traceSpan readSpan("load.read", "io");
+    if (!projectSerializer::readProject(filename, projectName, *objects, checkpointId, deltaSegments))
+    {
+        return false;
+    }
+    readSpan.end();
+
+    // Last point to back out; after the swap the load is logged and cannot be cancelled
+    if (progress && !progress(0.9))
+    {
+        return false;
+    }
+
+    traceSpan swapSpan("load.swap", "core");
+    uint64_t contentHash = tableHash(*objects);
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    objects_ = std::move(objects);
+    contentHash_ = contentHash;
+    if (!projectName.empty())
+    {
+        currentProject_ = projectName;
+    }
+    dirtyObjects_.clear();
+    deletedObjects_.clear();
+    indexChanges_.clear();
+    indexStale_ = true;
+    checkpointFile_ = filename;
+    checkpointId_ = checkpointId;
+    deltaSegments_ = deltaSegments;
+    ++checkpointEpoch_;
+    uint64_t lsn = logMutation(nlohmann::json{{"op", "load"}, {"file", filename}}.dump());
+    lock.unlock();
+    swapSpan.end();
+
+    traceSpan logSpan("load.log_wait", "io");
+    waitForLog(lsn);
+    return true;
+}
+
+softwareCore::sceneSnapshot softwareCore::snapshot() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return {currentProject_, objects_, contentHash_};
 }
 
 bool softwareCore::executeCommand(const std::string& command, const std::map<std::string, std::string>& params)
 {
+    traceSpan span("softwareCore::executeCommand", "core");
     if (command == "render")
     {
-        // Simulate rendering
-        return true;
+        renderSettings settings;
+        renderResult result;
+        std::string error;
+        return sceneRenderer::parseSettings(params, settings, error) && render(settings, result, error);
     }
     else if (command == "clear_scene")
     {
-        objects_.clear();
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        for (const auto& pair : *objects_)
+        {
+            deletedObjects_.insert(pair.first);
+        }
+        dirtyObjects_.clear();
+        indexChanges_.clear();
+        indexStale_ = true;
+        objects_ = std::make_shared<objectTable>();
+        contentHash_ = 0;
+        uint64_t lsn = logMutation(nlohmann::json{{"op", "execute"}, {"command", command}, {"params", params}}.dump());
+        lock.unlock();
+
+        waitForLog(lsn);
         return true;
     }
     else if (command == "reset_camera")
     {
         // Find and reset camera
-        for (auto& pair : objects_)
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        for (auto& pair : mutableObjects())
         {
-            if (pair.second.type_ == "camera")
+            if (pair.second->type_ == "camera")
             {
-                pair.second.properties_["position"] = "0,0,5";
-                pair.second.properties_["rotation"] = "0,0,0";
+                auto camera = std::make_shared<softwareObject>(*pair.second);
+                camera->properties_["position"] = "0,0,5";
+                camera->properties_["rotation"] = "0,0,0";
+                contentHash_ += objectHash(pair.first, *camera) - objectHash(pair.first, *pair.second);
+                pair.second = std::move(camera);
+                dirtyObjects_.insert(pair.first);
             }
         }
+        uint64_t lsn = logMutation(nlohmann::json{{"op", "execute"}, {"command", command}, {"params", params}}.dump());
+        lock.unlock();
+
+        waitForLog(lsn);
         return true;
     }
     return false;  // Unknown command
 }
 
+bool softwareCore::render(const renderSettings& settings, renderResult& outResult, std::string& outError,
+                          const progressCallback& progress)
+{
+    std::vector<renderResult> results;
+    if (!renderViews({settings}, results, outError, progress))
+    {
+        return false;
+    }
+    outResult = std::move(results.front());
+    return true;
+}
+
+bool softwareCore::renderCameras(const renderSettings& settings, const std::vector<std::string>& cameraIds,
+                                 std::vector<renderResult>& outResults, std::string& outError,
+                                 const progressCallback& progress)
+{
+    std::vector<std::string> ids = cameraIds;
+    if (ids.empty())
+    {
+        for (const auto& pair : *snapshot().objects_)
+        {
+            if (pair.second->type_ == "camera")
+            {
+                ids.push_back(pair.first);
+            }
+        }
+        if (ids.empty())
+        {
+            outError = "Scene has no cameras";
+            return false;
+        }
+    }
+
+    // One output per camera: the file name or segment gets the camera ID appended
+    std::vector<renderSettings> views;
+    std::set<std::string> seen;
+    for (const std::string& id : ids)
+    {
+        if (!seen.insert(id).second)
+        {
+            continue;
+        }
+        renderSettings view = settings;
+        view.cameraId_ = id;
+        size_t dot = view.outputFile_.find_last_of('.');
+        size_t slash = view.outputFile_.find_last_of("/\\");
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        {
+            dot = view.outputFile_.size();
+        }
+        view.outputFile_.insert(dot, "_" + id);
+        if (!view.sharedMemoryName_.empty())
+        {
+            view.sharedMemoryName_ += "_" + id;
+        }
+        views.push_back(std::move(view));
+    }
+    return renderViews(views, outResults, outError, progress);
+}
+
+bool softwareCore::renderViews(const std::vector<renderSettings>& views, std::vector<renderResult>& outResults,
+                               std::string& outError, const progressCallback& progress)
+{
+    traceSpan span("softwareCore::renderViews", "core");
+    auto start = std::chrono::steady_clock::now();
+    std::vector<renderResult> results(views.size());
+
+    // Streaming callers want the tiles, so they always trace; shared-memory output takes raw pixels, not
+    // cached encoded images, and relies on incremental rendering instead
+    uint64_t sceneHash = snapshot().contentHash_;
+    std::vector<renderSettings> misses;
+    std::vector<size_t> missSlots;
+    for (size_t i = 0; i < views.size(); ++i)
+    {
+        const renderSettings& settings = views[i];
+        renderCache::entry cached;
+        if (settings.tileSink_ || !settings.sharedMemoryName_.empty() ||
+            !renderCache_->find(renderCache::key(sceneHash, settings), cached))
+        {
+            misses.push_back(settings);
+            missSlots.push_back(i);
+            continue;
+        }
+        if (!imageEncoder::writeFile(settings.outputFile_, *cached.image_))
+        {
+            outError = "Could not write image file: " + settings.outputFile_;
+            return false;
+        }
+        renderResult& result = results[i];
+        result.outputFile_ = settings.outputFile_;
+        result.cameraId_ = cached.cameraId_;
+        result.width_ = settings.width_;
+        result.height_ = settings.height_;
+        result.samplesPerPixel_ = settings.samplesPerPixel_;
+        result.tiles_ = cached.tiles_;
+        result.simdLevel_ = cached.simdLevel_;
+        result.cacheHit_ = true;
+        result.image_ = cached.image_;
+        result.renderMilliseconds_ =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // The misses trace one snapshot together, so edits made meanwhile land in the next render
+    if (!misses.empty())
+    {
+        sceneSnapshot scene;
+        std::shared_ptr<const sceneIndex> index = currentIndex(scene);
+        std::vector<renderResult> rendered;
+        if (!renderer_->renderViews(scene, *index, misses, rendered, outError, progress))
+        {
+            return false;
+        }
+        for (size_t i = 0; i < misses.size(); ++i)
+        {
+            renderResult& result = rendered[i];
+            renderCache_->insert(renderCache::key(scene.contentHash_, misses[i]),
+                                 {result.image_, result.cameraId_, result.tiles_, result.simdLevel_});
+            results[missSlots[i]] = std::move(result);
+        }
+    }
+    outResults = std::move(results);
+    return true;
+}
+
+void softwareCore::queryRegion(const aabb& region, std::vector<std::string>& outObjectIds)
+{
+    traceSpan span("softwareCore::queryRegion", "core");
+    sceneSnapshot scene;
+    currentIndex(scene)->queryRegion(region, outObjectIds);
+}
+
+bool softwareCore::raycast(const vec3& origin, const vec3& direction, float maxDistance, std::string& outObjectId,
+                           float& outDistance)
+{
+    traceSpan span("softwareCore::raycast", "core");
+    sceneSnapshot scene;
+    std::shared_ptr<const sceneIndex> index = currentIndex(scene);
+
+    // A packet with a single live lane; the others have no search distance
+    rayPacket packet;
+    vec3 unit = direction.normalized();
+    for (int lane = 0; lane < rayPacket::kWidth; ++lane)
+    {
+        packet.originX_[lane] = origin.x_;
+        packet.originY_[lane] = origin.y_;
+        packet.originZ_[lane] = origin.z_;
+        packet.directionX_[lane] = unit.x_;
+        packet.directionY_[lane] = unit.y_;
+        packet.directionZ_[lane] = unit.z_;
+        packet.distance_[lane] = lane == 0 ? maxDistance : 0.0f;
+    }
+    index->intersect(packet, rayPacketKernels::best());
+    if (packet.primitive_[0] < 0)
+    {
+        return false;
+    }
+    outObjectId = index->objectId(packet.primitive_[0]);
+    outDistance = packet.distance_[0];
+    return true;
+}
+
+bool softwareCore::enableWriteAheadLog(const std::string& path, writeAheadLog::syncPolicy policy,
+                                       size_t& outReplayed)
+{
+    // A missing log just means there is nothing to recover
+    std::vector<std::pair<uint64_t, std::string>> entries;
+    uint64_t validBytes = 0;
+    writeAheadLog::readLog(path, entries, validBytes);
+
+    // New records must not be appended onto a torn one, or the next recovery would stop there
+    bool truncated = false;
+    if (!writeAheadLog::truncateTail(path, validBytes, truncated))
+    {
+        logger::error("wal", "Failed to truncate torn write-ahead log tail", {{"path", path}});
+        return false;
+    }
+    if (truncated)
+    {
+        logger::warn("wal", "Dropped torn record at end of write-ahead log",
+                     {{"path", path}, {"valid_bytes", validBytes}});
+    }
+
+    std::vector<std::pair<uint64_t, nlohmann::json>> records;
+    uint64_t checkpointLsn = 0;
+    uint64_t lastLsn = 0;
+    std::string checkpointFile;
+    for (const auto& entry : entries)
+    {
+        nlohmann::json record = nlohmann::json::parse(entry.second);
+        if (record.value("op", "") == "checkpoint")
+        {
+            checkpointLsn = entry.first;
+            checkpointFile = record.value("file", "");
+        }
+        lastLsn = std::max(lastLsn, entry.first);
+        records.emplace_back(entry.first, std::move(record));
+    }
+
+    if (!checkpointFile.empty() && !loadProject(checkpointFile))
+    {
+        return false;
+    }
+
+    // Records after the checkpoint are replayed through the normal paths; log_ is not attached yet
+    outReplayed = 0;
+    for (const auto& entry : records)
+    {
+        const nlohmann::json& record = entry.second;
+        std::string op = record.value("op", "");
+        if (entry.first <= checkpointLsn || op == "checkpoint")
+        {
+            continue;
+        }
+
+        if (op == "create" || op == "update")
+        {
+            auto obj = std::make_shared<softwareObject>(projectSerializer::objectFromJson(record["object"]));
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            storeObject(record["id"].get<std::string>(), std::move(obj));
+            dirtyObjects_.insert(record["id"].get<std::string>());
+            indexChanges_.insert(record["id"].get<std::string>());
+        }
+        else if (op == "delete")
+        {
+            deleteObject(record["id"].get<std::string>());
+        }
+        else if (op == "execute")
+        {
+            executeCommand(record["command"].get<std::string>(),
+                           record["params"].get<std::map<std::string, std::string>>());
+        }
+        else if (op == "load" && !loadProject(record["file"].get<std::string>()))
+        {
+            // Later records were made against that scene; replaying them onto another would be silently wrong
+            logger::error("wal", "Cannot load project file named by the write-ahead log",
+                          {{"file", record["file"].get<std::string>()}, {"lsn", entry.first}});
+            return false;
+        }
+        ++outReplayed;
+    }
+
+    try
+    {
+        auto log = std::make_shared<writeAheadLog>(path, policy, lastLsn + 1);
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        log_ = std::move(log);
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+    return true;
+}
+
+void softwareCore::configureRenderCache(size_t memoryBytes, const std::string& spillDirectory, size_t spillBytes)
+{
+    renderCache_->configure(memoryBytes, spillDirectory, spillBytes);
+}
+
+bool softwareCore::measureMemory(memoryReport& outReport, const progressCallback& progress)
+{
+    traceSpan span("softwareCore::measureMemory", "core");
+    outReport = memoryReport();
+
+    // Only counts are read under the lock; the walk runs on the snapshot while mutations continue
+    sceneSnapshot scene;
+    size_t trackedIds;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        scene = {currentProject_, objects_, contentHash_};
+        trackedIds = dirtyObjects_.size() + deletedObjects_.size() + indexChanges_.size();
+    }
+
+    const objectTable& objects = *scene.objects_;
+    size_t idBytes = 0;
+    size_t measured = 0;
+    for (const auto& pair : objects)
+    {
+        const softwareObject& obj = *pair.second;
+        typeFootprint& type = outReport.types_[obj.type_];
+        size_t ownStrings = memoryFootprint::stringBytes(pair.first) + memoryFootprint::stringBytes(obj.name_) +
+                            memoryFootprint::stringBytes(obj.type_);
+        size_t propertyBytes = 0;
+        size_t propertyStrings = 0;
+        for (const auto& property : obj.properties_)
+        {
+            size_t strings =
+                memoryFootprint::stringBytes(property.first) + memoryFootprint::stringBytes(property.second);
+            size_t bytes = memoryFootprint::kTreeNodeOverhead +
+                           sizeof(std::map<std::string, std::string>::value_type) + strings;
+            propertyFootprint& named = outReport.properties_[property.first];
+            ++named.objects_;
+            named.bytes_ += bytes;
+            propertyBytes += bytes;
+            propertyStrings += strings;
+        }
+
+        ++type.objects_;
+        type.bytes_ += memoryFootprint::kTreeNodeOverhead + sizeof(objectTable::value_type) +
+                       memoryFootprint::kSharedControlBytes + sizeof(softwareObject) + ownStrings + propertyBytes;
+        type.propertyBytes_ += propertyBytes;
+        type.stringBytes_ += ownStrings + propertyStrings;
+        idBytes += memoryFootprint::stringBytes(pair.first);
+
+        if (++measured % kMeasureProgressInterval == 0 && progress &&
+            !progress(static_cast<double>(measured) / static_cast<double>(objects.size())))
+        {
+            return false;
+        }
+    }
+    outReport.objects_ = objects.size();
+
+    // The tracked IDs are not walked under the lock; their buffers are taken to match the table's average
+    outReport.changeTrackingBytes_ = trackedIds * (memoryFootprint::kTreeNodeOverhead + sizeof(std::string));
+    if (!objects.empty())
+    {
+        outReport.changeTrackingBytes_ += trackedIds * idBytes / objects.size();
+    }
+
+    // The current index, if a render or query has built one; its copy-on-write keeps this one unchanged
+    std::shared_ptr<const sceneIndex> index;
+    {
+        std::lock_guard<std::mutex> indexLock(indexMutex_);
+        index = index_;
+    }
+    if (index)
+    {
+        outReport.indexBuilt_ = true;
+        outReport.index_ = index->measureMemory();
+    }
+    outReport.renderCache_ = renderCache_->measureMemory();
+    outReport.frames_ = renderer_->measureMemory();
+    return true;
+}
+
 std::string softwareCore::generateObjectId()
 {
     static std::random_device rd;
@@ -224,6 +799,16 @@ std::string softwareCore::generateObjectId()
     return ss.str();
 }
 
+std::string softwareCore::generateCheckpointId()
+{
+    static std::random_device rd;
+    static std::mt19937_64 gen(rd());
+
+    std::stringstream ss;
+    ss << std::hex << std::setfill('0') << std::setw(16) << gen();
+    return ss.str();
+}
+
 bool softwareCore::validateObjectType(const std::string& type)
 {
     return type == "cube" || type == "sphere" || type == "camera";
@@ -244,6 +829,125 @@ void softwareCore::initializeDefaultObjects()
     obj2.properties_["position"] = "0,0,5";
     obj2.properties_["rotation"] = "0,0,0";
 
-    objects_["obj_001"] = obj1;
-    objects_["obj_002"] = obj2;
+    (*objects_)["obj_001"] = std::make_shared<softwareObject>(std::move(obj1));
+    (*objects_)["obj_002"] = std::make_shared<softwareObject>(std::move(obj2));
+    contentHash_ = tableHash(*objects_);
+}
+
+softwareCore::objectTable& softwareCore::mutableObjects()
+{
+    // Outstanding snapshots still reference the table, so detach with a shallow copy first
+    if (objects_.use_count() > 1)
+    {
+        objects_ = std::make_shared<objectTable>(*objects_);
+    }
+    return *objects_;
+}
+
+void softwareCore::storeObject(const std::string& objectId, std::shared_ptr<const softwareObject> obj)
+{
+    objectTable& objects = mutableObjects();
+    auto it = objects.find(objectId);
+    if (it != objects.end())
+    {
+        contentHash_ -= objectHash(it->first, *it->second);
+    }
+    if (!obj)
+    {
+        if (it != objects.end())
+        {
+            objects.erase(it);
+        }
+        return;
+    }
+    contentHash_ += objectHash(objectId, *obj);
+    objects[objectId] = std::move(obj);
+}
+
+uint64_t softwareCore::objectHash(const std::string& objectId, const softwareObject& obj)
+{
+    // FNV-1a over every field, with separators so adjacent strings cannot run together
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const std::string& text)
+    {
+        for (unsigned char c : text)
+        {
+            hash = (hash ^ c) * 1099511628211ull;
+        }
+        hash = (hash ^ 0xffu) * 1099511628211ull;
+    };
+    mix(objectId);
+    mix(obj.name_);
+    mix(obj.type_);
+    for (const auto& property : obj.properties_)
+    {
+        mix(property.first);
+        mix(property.second);
+    }
+
+    // Finalize so the per-object hashes can be summed without structured cancellation
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+uint64_t softwareCore::tableHash(const objectTable& objects)
+{
+    uint64_t hash = 0;
+    for (const auto& pair : objects)
+    {
+        hash += objectHash(pair.first, *pair.second);
+    }
+    return hash;
+}
+
+uint64_t softwareCore::logMutation(const std::string& record)
+{
+    // Appending under the scene lock keeps log order identical to apply order
+    return log_ ? log_->append(record) : 0;
+}
+
+void softwareCore::waitForLog(uint64_t lsn)
+{
+    if (log_ && lsn != 0 && !log_->waitDurable(lsn))
+    {
+        throw std::runtime_error("Write-ahead log sync failed; the change is applied but not durable");
+    }
+}
+
+std::shared_ptr<const sceneIndex> softwareCore::currentIndex(sceneSnapshot& outScene)
+{
+    traceSpan span("softwareCore::currentIndex", "core");
+    std::lock_guard<std::mutex> indexLock(indexMutex_);
+
+    // Take the pending changes together with the snapshot they lead up to
+    std::set<std::string> changes;
+    bool stale;
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        outScene = {currentProject_, objects_, contentHash_};
+        changes.swap(indexChanges_);
+        stale = indexStale_;
+        indexStale_ = false;
+    }
+
+    if (!stale && index_ && !changes.empty())
+    {
+        // Renders in flight may still be traversing the current index
+        if (index_.use_count() > 1)
+        {
+            index_ = std::make_shared<sceneIndex>(*index_);
+        }
+        stale = !index_->update(*outScene.objects_, changes);
+    }
+    if (stale || !index_)
+    {
+        auto index = std::make_shared<sceneIndex>();
+        index->rebuild(*outScene.objects_, workers_.get());
+        index_ = std::move(index);
+    }
+    return index_;
 }
@@ -1,9 +1,26 @@
 #pragma once
 
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
 #include <string>
 #include <vector>
 
+#include "renderCache.hpp"
+#include "sceneGeometry.hpp"
+#include "writeAheadLog.hpp"
+
+class sceneIndex;
+class sceneRenderer;
+class threadPool;
+struct renderSettings;
+struct renderResult;
+
 // Core business logic for the software
 class softwareCore
 {
@@ -25,7 +42,102 @@ class softwareCore
         std::map<std::string, std::string> properties_;
     };
 
+    // Objects are immutable once published so snapshots can share them with the live scene
+    using objectTable = std::map<std::string, std::shared_ptr<const softwareObject>>;
+
+    // Logical copy of the scene taken in O(1); stays valid while the core keeps mutating
+    struct sceneSnapshot
+    {
+        std::string projectName_;
+        std::shared_ptr<const objectTable> objects_;
+        uint64_t contentHash_;  // Equal for scenes with identical objects, regardless of history
+    };
+
+    // Full rewrites the file; delta appends only objects changed since the last checkpoint
+    enum class saveMode
+    {
+        full,
+        delta
+    };
+
+    // Reports completion in [0, 1] for long operations; returning false asks the operation to stop.
+    // Render calls it from its worker threads.
+    using progressCallback = std::function<bool(double progress)>;
+
+    struct saveOptions
+    {
+        saveMode mode_ = saveMode::full;
+        size_t threads_ = 1;  // Full saves serialize shards of the object table on this many threads
+        bool compress_ = false;
+        progressCallback progress_;
+    };
+
+    // A save snapshotted when it was requested, to be written later, possibly on another thread. Saves are
+    // written in the order they were prepared; one destroyed unwritten (a cancelled job) leaves its changes
+    // pending for the next save.
+    struct preparedSave
+    {
+        preparedSave() = default;
+        preparedSave(const preparedSave&) = delete;
+        preparedSave& operator=(const preparedSave&) = delete;
+        ~preparedSave();
+
+        softwareCore* core_ = nullptr;
+        std::string filename_;
+        saveOptions options_;
+        sceneSnapshot scene_;
+        std::set<std::string> dirty_;  // Change sets taken with the snapshot
+        std::set<std::string> deleted_;
+        size_t epoch_ = 0;
+        uint64_t coveredLsn_ = 0;  // Last log record the snapshot includes
+        uint64_t ticket_ = 0;      // Position in the save order
+        bool finished_ = false;
+    };
+
+    // Estimated heap footprint of the scene and of what is derived from it, from container sizes and
+    // capacities (see memoryFootprint)
+    struct typeFootprint
+    {
+        size_t objects_ = 0;
+        size_t bytes_ = 0;          // Objects with their table entries, properties and strings
+        size_t propertyBytes_ = 0;  // Property map nodes with their names and values
+        size_t stringBytes_ = 0;    // Heap buffers of IDs, names, types and property strings
+    };
+
+    struct propertyFootprint
+    {
+        size_t objects_ = 0;  // Objects that have the property
+        size_t bytes_ = 0;
+    };
+
+    struct indexFootprint
+    {
+        size_t slots_ = 0;
+        size_t bvhBytes_ = 0;
+        size_t slotBytes_ = 0;    // IDs, primitives, bounds and the ID-to-slot map
+        size_t packedBytes_ = 0;  // Leaf-order copies for the packet kernels
+    };
+
+    struct frameFootprint
+    {
+        size_t frames_ = 0;
+        size_t bytes_ = 0;  // Last frame per camera, kept for incremental renders
+    };
+
+    struct memoryReport
+    {
+        size_t objects_ = 0;
+        std::map<std::string, typeFootprint> types_;
+        std::map<std::string, propertyFootprint> properties_;  // By property name
+        size_t changeTrackingBytes_ = 0;  // IDs waiting for the next delta save or index update
+        bool indexBuilt_ = false;
+        indexFootprint index_;
+        renderCache::footprint renderCache_;
+        frameFootprint frames_;
+    };
+
     softwareCore();  // Software information
+    ~softwareCore();
 
     // Core operations
     softwareInfo getSoftwareInfo() const;
@@ -35,25 +147,96 @@ class softwareCore
     std::string createObject(const std::string& name, const std::string& type,
                              const std::map<std::string, std::string>& properties = {});
     bool deleteObject(const std::string& objectId);
+    bool updateObject(const std::string& objectId, const std::map<std::string, std::string>& properties);
     std::vector<std::pair<std::string, softwareObject>> listObjects() const;
     bool getObjectInfo(const std::string& objectId, softwareObject& outObject) const;
 
     // Project management
     bool saveProject(const std::string& filename);
-    bool loadProject(const std::string& filename);
+    bool saveProject(const std::string& filename, const saveOptions& options, saveMode& outWrittenMode);
+    // Snapshots the scene and takes its change sets now; saveProject(save, ...) writes them later
+    std::shared_ptr<preparedSave> prepareSave(const std::string& filename, const saveOptions& options);
+    bool saveProject(preparedSave& save, const progressCallback& progress, saveMode& outWrittenMode);
+    bool loadProject(const std::string& filename, const progressCallback& progress = nullptr);
+    sceneSnapshot snapshot() const;
 
     // Software operations
     bool executeCommand(const std::string& command, const std::map<std::string, std::string>& params = {});
+    bool render(const renderSettings& settings, renderResult& outResult, std::string& outError,
+                const progressCallback& progress = nullptr);
+    // Renders the scene from each listed camera (all cameras when empty) with one shared index build,
+    // writing one output per camera
+    bool renderCameras(const renderSettings& settings, const std::vector<std::string>& cameraIds,
+                       std::vector<renderResult>& outResults, std::string& outError,
+                       const progressCallback& progress = nullptr);
+
+    // Spatial queries over visible objects (spheres and cubes), answered from the BVH
+    void queryRegion(const aabb& region, std::vector<std::string>& outObjectIds);
+    bool raycast(const vec3& origin, const vec3& direction, float maxDistance, std::string& outObjectId,
+                 float& outDistance);
+
+    // Crash recovery - replays the log on top of its last checkpoint, then logs every mutation.
+    // Call once before serving requests.
+    bool enableWriteAheadLog(const std::string& path, writeAheadLog::syncPolicy policy, size_t& outReplayed);
+
+    // Repeated renders of an unchanged scene are served from a cache of encoded images; an empty
+    // directory keeps it in memory only
+    void configureRenderCache(size_t memoryBytes, const std::string& spillDirectory, size_t spillBytes);
+
+    // Walks a snapshot of the scene, so writers are not held up however large it is. Progress is reported
+    // every few thousand objects; returning false from it abandons the walk and returns false.
+    bool measureMemory(memoryReport& outReport, const progressCallback& progress = nullptr);
 
   private:
-    std::map<std::string, softwareObject> objects_;
+    mutable std::shared_mutex mutex_;  // Readers share, mutations are exclusive
+    std::shared_ptr<objectTable> objects_;
+    uint64_t contentHash_;  // Sum of objectHash over objects_, maintained by storeObject
     std::string currentProject_;
     bool isRunning_;
     std::string softwareName_;
     std::string version_;
 
+    // Change tracking relative to the last full save or load (the checkpoint)
+    std::set<std::string> dirtyObjects_;
+    std::set<std::string> deletedObjects_;
+    std::string checkpointFile_;
+    std::string checkpointId_;
+    size_t deltaSegments_;
+    size_t checkpointEpoch_;  // Bumped by loads so in-flight saves don't overwrite the new checkpoint
+    uint64_t nextSaveTicket_;  // Handed out with each snapshot, under mutex_
+
+    // Prepared saves are written one at a time in ticket order, so delta segments are appended in sequence
+    std::mutex saveMutex_;
+    std::condition_variable saveTurnCv_;
+    uint64_t saveTurn_;                 // Ticket of the save allowed to write next
+    std::set<uint64_t> releasedSaves_;  // Saves finished or dropped out of turn, waiting to be skipped
+    std::shared_ptr<writeAheadLog> log_;
+    std::unique_ptr<threadPool> workers_;  // Shared by rendering and index builds
+    std::unique_ptr<sceneRenderer> renderer_;
+    std::unique_ptr<renderCache> renderCache_;
+
+    bool renderViews(const std::vector<renderSettings>& views, std::vector<renderResult>& outResults,
+                     std::string& outError, const progressCallback& progress);
+
+    // BVH for the current scene, brought up to date lazily by the next render or query
+    std::mutex indexMutex_;  // Serializes index maintenance; taken before mutex_
+    std::shared_ptr<sceneIndex> index_;
+    std::set<std::string> indexChanges_;  // Objects touched since the index was last updated
+    bool indexStale_;                     // Whole-scene changes (load, clear) need a rebuild
+
     // Helper methods
     static std::string generateObjectId();
+    static std::string generateCheckpointId();
     static bool validateObjectType(const std::string& type);
     void initializeDefaultObjects();
+    objectTable& mutableObjects();                 // Caller must hold the exclusive lock
+    void abandonSave(preparedSave& save);
+    void releaseSaveTurn(uint64_t ticket);
+    void storeObject(const std::string& objectId,
+                     std::shared_ptr<const softwareObject> obj);  // Null erases; caller must hold the exclusive lock
+    static uint64_t objectHash(const std::string& objectId, const softwareObject& obj);
+    static uint64_t tableHash(const objectTable& objects);
+    uint64_t logMutation(const std::string& record);  // Caller must hold the exclusive lock
+    void waitForLog(uint64_t lsn);                    // Group commit wait after unlocking; throws on failure
+    std::shared_ptr<const sceneIndex> currentIndex(sceneSnapshot& outScene);
 };
@@ -0,0 +1,157 @@
+#include "threadPool.hpp"
+#include "traceRecorder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+threadPool::threadPool(size_t threads) : queued_(0), stopping_(false)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threads; ++i)
+    {
+        queues_.push_back(std::make_unique<workerQueue>());
+    }
+    for (size_t i = 0; i < threads; ++i)
+    {
+        workers_.emplace_back(&threadPool::workerLoop, this, i);
+    }
+}
+
+threadPool::~threadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        stopping_ = true;
+    }
+    wakeCv_.notify_all();
+    for (auto& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+size_t threadPool::size() const
+{
+    return queues_.size();
+}
+
+void threadPool::parallelFor(size_t count, const std::function<void(size_t)>& task)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    struct batchState
+    {
+        std::atomic<size_t> remaining_;
+        std::mutex mutex_;
+        std::condition_variable done_;
+        std::exception_ptr error_;
+    };
+    auto batch = std::make_shared<batchState>();
+    batch->remaining_ = count;
+    queued_ += count;  // Counted before pushing so a fast pop can never underflow it
+
+    // Contiguous ranges per queue keep neighbouring tasks on one worker; stealing evens out the rest
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto job = [batch, &task, i]()
+        {
+            try
+            {
+                task(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(batch->mutex_);
+                if (!batch->error_)
+                {
+                    batch->error_ = std::current_exception();
+                }
+            }
+            if (--batch->remaining_ == 0)
+            {
+                std::lock_guard<std::mutex> lock(batch->mutex_);
+                batch->done_.notify_all();
+            }
+        };
+
+        workerQueue& queue = *queues_[i * queues_.size() / count];
+        std::lock_guard<std::mutex> lock(queue.mutex_);
+        queue.tasks_.push_back(std::move(job));
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+    }
+    wakeCv_.notify_all();
+
+    std::function<void()> job;
+    while (batch->remaining_ > 0)
+    {
+        if (tryPop(0, job))
+        {
+            job();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(batch->mutex_);
+        batch->done_.wait_for(lock, std::chrono::milliseconds(1), [&batch] { return batch->remaining_ == 0; });
+    }
+
+    if (batch->error_)
+    {
+        std::rethrow_exception(batch->error_);
+    }
+}
+
+bool threadPool::tryPop(size_t preferred, std::function<void()>& outTask)
+{
+    // Take from the front of the preferred queue, steal from the back of the others
+    for (size_t n = 0; n < queues_.size(); ++n)
+    {
+        workerQueue& queue = *queues_[(preferred + n) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex_);
+        if (queue.tasks_.empty())
+        {
+            continue;
+        }
+        if (n == 0)
+        {
+            outTask = std::move(queue.tasks_.front());
+            queue.tasks_.pop_front();
+        }
+        else
+        {
+            outTask = std::move(queue.tasks_.back());
+            queue.tasks_.pop_back();
+        }
+        --queued_;
+        return true;
+    }
+    return false;
+}
+
+void threadPool::workerLoop(size_t index)
+{
+    traceRecorder::setThreadName("pool worker");
+    std::function<void()> task;
+    while (true)
+    {
+        if (tryPop(index, task))
+        {
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        wakeCv_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+        if (stopping_ && queued_ == 0)
+        {
+            return;
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool - each worker drains its own queue and steals from the others when idle
+class threadPool
+{
+  public:
+    explicit threadPool(size_t threads = 0);  // 0 uses one worker per hardware thread
+    ~threadPool();
+
+    size_t size() const;
+
+    // Runs task(i) for every i in [0, count) and blocks until all are done. The calling thread
+    // helps, so nested calls from inside a task cannot deadlock the pool.
+    void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+  private:
+    struct workerQueue
+    {
+        std::mutex mutex_;
+        std::deque<std::function<void()>> tasks_;
+    };
+
+    std::vector<std::unique_ptr<workerQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex wakeMutex_;
+    std::condition_variable wakeCv_;
+    std::atomic<size_t> queued_;
+    bool stopping_;
+
+    bool tryPop(size_t preferred, std::function<void()>& outTask);
+    void workerLoop(size_t index);
+};
@@ -0,0 +1,196 @@
+#include "traceRecorder.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace
+{
+thread_local const char* localThreadName = nullptr;
+
+struct copiedEvent
+{
+    const char* name_;
+    const char* category_;
+    uint64_t nanoseconds_;
+    char phase_;
+};
+}  // namespace
+
+std::atomic<bool> traceRecorder::enabled_(false);
+
+traceRecorder::traceRecorder() : epoch_(std::chrono::steady_clock::now())
+{
+}
+
+traceRecorder& traceRecorder::instance()
+{
+    // Never destroyed, so threads still exiting at shutdown can record safely
+    static traceRecorder* recorder = new traceRecorder();
+    return *recorder;
+}
+
+void traceRecorder::start()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+                                  [](const std::shared_ptr<buffer>& b) { return b->retired_.load(); }),
+                   buffers_.end());
+    for (const auto& b : buffers_)
+    {
+        b->base_.store(b->head_.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+    droppedThreads_.store(0, std::memory_order_relaxed);
+    session_.fetch_add(1, std::memory_order_relaxed);
+    enabled_.store(true, std::memory_order_release);
+}
+
+void traceRecorder::stop()
+{
+    enabled_.store(false, std::memory_order_release);
+}
+
+void traceRecorder::setThreadName(const char* name)
+{
+    localThreadName = name;
+}
+
+void traceRecorder::record(const char* name, const char* category, char phase)
+{
+    buffer* b = localBuffer();
+    if (!b)
+    {
+        return;
+    }
+    uint64_t nanoseconds = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch_).count());
+    uint64_t head = b->head_.load(std::memory_order_relaxed);
+    event& e = b->events_[head & (kEventsPerThread - 1)];
+
+    // Pairs with the reader's acquire fence: a reader that sees any of these stores also sees head
+    std::atomic_thread_fence(std::memory_order_release);
+    e.name_.store(name, std::memory_order_relaxed);
+    e.category_.store(category, std::memory_order_relaxed);
+    e.nanoseconds_.store(nanoseconds, std::memory_order_relaxed);
+    e.phase_.store(phase, std::memory_order_relaxed);
+    b->head_.store(head + 1, std::memory_order_release);
+}
+
+bool traceRecorder::writeFile(const std::string& path, dumpStats& outStats, std::string& outError)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        outError = "Cannot open trace file: " + path;
+        return false;
+    }
+    write(file, outStats);
+    file.close();
+    if (!file)
+    {
+        outError = "Failed to write trace file: " + path;
+        return false;
+    }
+    return true;
+}
+
+void traceRecorder::write(std::ostream& out, dumpStats& outStats)
+{
+    outStats = dumpStats();
+    outStats.droppedThreads_ = droppedThreads_.load(std::memory_order_relaxed);
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+        << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"cpp_app\"}}";
+    out << std::fixed << std::setprecision(3);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<copiedEvent> copied;
+    for (const auto& b : buffers_)
+    {
+        // Copy the window, then drop whatever the owner may have overwritten while it was being read
+        uint64_t base = b->base_.load(std::memory_order_relaxed);
+        uint64_t head = b->head_.load(std::memory_order_acquire);
+        uint64_t first = std::max(base, head > kEventsPerThread ? head - kEventsPerThread : 0);
+        copied.clear();
+        for (uint64_t i = first; i < head; ++i)
+        {
+            const event& e = b->events_[i & (kEventsPerThread - 1)];
+            copied.push_back({e.name_.load(std::memory_order_relaxed),
+                              e.category_.load(std::memory_order_relaxed),
+                              e.nanoseconds_.load(std::memory_order_relaxed),
+                              e.phase_.load(std::memory_order_relaxed)});
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = b->head_.load(std::memory_order_relaxed);
+        uint64_t valid = after >= kEventsPerThread ? after - kEventsPerThread + 1 : 0;
+        size_t skip = valid > first ? static_cast<size_t>(std::min(valid - first, head - first)) : 0;
+        outStats.overwritten_ += (first - base) + skip;
+        if (head == base)
+        {
+            continue;
+        }
+
+        ++outStats.threads_;
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->tid_ << ",\"args\":{\"name\":\""
+            << b->threadName_ << "\"}}";
+
+        // Ends whose begin fell out of the window would close spans of the thread's parent on the timeline
+        int depth = 0;
+        for (size_t i = skip; i < copied.size(); ++i)
+        {
+            const copiedEvent& e = copied[i];
+            if (e.phase_ == 'E' && depth == 0)
+            {
+                continue;
+            }
+            depth += e.phase_ == 'B' ? 1 : -1;
+            out << ",\n{\"name\":\"" << e.name_ << "\",\"cat\":\"" << e.category_ << "\",\"ph\":\"" << e.phase_
+                << "\",\"ts\":" << e.nanoseconds_ / 1000.0 << ",\"pid\":1,\"tid\":" << b->tid_ << "}";
+            ++outStats.events_;
+        }
+    }
+    out << "\n]}\n";
+}
+
+traceRecorder::buffer* traceRecorder::localBuffer()
+{
+    thread_local threadHandle local;
+    if (local.buffer_)
+    {
+        return local.buffer_.get();
+    }
+    uint64_t session = session_.load(std::memory_order_relaxed);
+    if (local.denied_ && local.session_ == session)
+    {
+        return nullptr;
+    }
+
+    // First event of this thread: claim a buffer, evicting one of an exited thread when at the limit
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (buffers_.size() >= kMaxBuffers)
+    {
+        auto retired = std::find_if(buffers_.begin(), buffers_.end(),
+                                    [](const std::shared_ptr<buffer>& b) { return b->retired_.load(); });
+        if (retired == buffers_.end())
+        {
+            local.denied_ = true;
+            local.session_ = session;
+            droppedThreads_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        buffers_.erase(retired);
+    }
+    auto created = std::make_shared<buffer>();
+    created->tid_ = nextTid_++;
+    created->threadName_ = localThreadName ? localThreadName : "thread " + std::to_string(created->tid_);
+    buffers_.push_back(created);
+    local.buffer_ = created;
+    return created.get();
+}
+
+traceRecorder::threadHandle::~threadHandle()
+{
+    if (buffer_)
+    {
+        buffer_->retired_.store(true);
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Process-wide span tracer writing Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev). Each thread
+// appends begin/end events to its own ring buffer, so recording takes no lock; when tracing is off a span
+// costs one relaxed load. Span names and categories must be string literals, since only pointers are kept.
+class traceRecorder
+{
+  public:
+    static constexpr size_t kEventsPerThread = 8192;  // Power of two; older events are overwritten
+    static constexpr size_t kMaxBuffers = 128;        // Exited threads' buffers are dropped beyond this
+
+    struct dumpStats
+    {
+        size_t events_ = 0;
+        size_t threads_ = 0;
+        uint64_t overwritten_ = 0;  // Events lost to ring wrap-around
+        uint64_t droppedThreads_ = 0;  // Threads that found no buffer slot
+    };
+
+    static traceRecorder& instance();
+
+    static bool enabled()
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    // Starting discards what earlier sessions recorded; stopping keeps the buffers for writing
+    void start();
+    void stop();
+
+    bool writeFile(const std::string& path, dumpStats& outStats, std::string& outError);
+    void write(std::ostream& out, dumpStats& outStats);
+
+    // Shown as the thread's name on the timeline; call before the thread records anything
+    static void setThreadName(const char* name);
+
+    void record(const char* name, const char* category, char phase);
+
+  private:
+    struct event
+    {
+        std::atomic<const char*> name_{nullptr};
+        std::atomic<const char*> category_{nullptr};
+        std::atomic<uint64_t> nanoseconds_{0};
+        std::atomic<char> phase_{0};
+    };
+
+    // Written only by its thread; readers copy a window and discard what was overwritten meanwhile
+    struct buffer
+    {
+        uint32_t tid_ = 0;
+        std::string threadName_;
+        std::atomic<uint64_t> head_{0};
+        std::atomic<uint64_t> base_{0};  // First event of the current session
+        std::atomic<bool> retired_{false};
+        std::array<event, kEventsPerThread> events_;
+    };
+
+    struct threadHandle
+    {
+        std::shared_ptr<buffer> buffer_;
+        bool denied_ = false;
+        uint64_t session_ = 0;
+        ~threadHandle();
+    };
+
+    static std::atomic<bool> enabled_;
+    std::chrono::steady_clock::time_point epoch_;
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<buffer>> buffers_;
+    uint32_t nextTid_ = 1;
+    std::atomic<uint64_t> session_{1};
+    std::atomic<uint64_t> droppedThreads_{0};
+
+    traceRecorder();
+    buffer* localBuffer();
+};
+
+// Records a begin event now and the matching end event at end() or destruction
+class traceSpan
+{
+  public:
+    traceSpan(const char* name, const char* category) : name_(nullptr), category_(category)
+    {
+        if (traceRecorder::enabled())
+        {
+            name_ = name;
+            traceRecorder::instance().record(name_, category_, 'B');
+        }
+    }
+    ~traceSpan()
+    {
+        end();
+    }
+
+    traceSpan(const traceSpan&) = delete;
+    traceSpan& operator=(const traceSpan&) = delete;
+
+    // Ends even when tracing was stopped meanwhile, so the begin event keeps its pair
+    void end()
+    {
+        if (name_)
+        {
+            traceRecorder::instance().record(name_, category_, 'E');
+            name_ = nullptr;
+        }
+    }
+
+  private:
+    const char* name_;
+    const char* category_;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cmath>
+
+// Minimal 3D vector used by the renderer and spatial queries
+struct vec3
+{
+    float x_ = 0.0f;
+    float y_ = 0.0f;
+    float z_ = 0.0f;
+
+    vec3() = default;
+    vec3(float x, float y, float z) : x_(x), y_(y), z_(z)
+    {
+    }
+
+    vec3 operator+(const vec3& other) const
+    {
+        return {x_ + other.x_, y_ + other.y_, z_ + other.z_};
+    }
+    vec3 operator-(const vec3& other) const
+    {
+        return {x_ - other.x_, y_ - other.y_, z_ - other.z_};
+    }
+    vec3 operator*(float scale) const
+    {
+        return {x_ * scale, y_ * scale, z_ * scale};
+    }
+    vec3 operator*(const vec3& other) const
+    {
+        return {x_ * other.x_, y_ * other.y_, z_ * other.z_};
+    }
+    float operator[](int axis) const
+    {
+        return axis == 0 ? x_ : (axis == 1 ? y_ : z_);
+    }
+
+    float dot(const vec3& other) const
+    {
+        return x_ * other.x_ + y_ * other.y_ + z_ * other.z_;
+    }
+    vec3 cross(const vec3& other) const
+    {
+        return {y_ * other.z_ - z_ * other.y_, z_ * other.x_ - x_ * other.z_, x_ * other.y_ - y_ * other.x_};
+    }
+    float length() const
+    {
+        return std::sqrt(dot(*this));
+    }
+    vec3 normalized() const
+    {
+        float len = length();
+        return len > 0.0f ? *this * (1.0f / len) : *this;
+    }
+};
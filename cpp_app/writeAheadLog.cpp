@@ -0,0 +1,339 @@
+#include "writeAheadLog.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include "logger.hpp"
+#include "nlohmann/json.hpp"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+writeAheadLog::writeAheadLog(const std::string& path, syncPolicy policy, uint64_t nextLsn,
+                             std::chrono::milliseconds syncInterval)
+    : path_(path),
+      policy_(policy),
+      syncInterval_(syncInterval),
+      fd_(-1),
+      nextLsn_(nextLsn),
+      durableLsn_(nextLsn - 1),
+      failed_(false),
+      stopping_(false)
+{
+    if (!openLog(path_, false))
+    {
+        throw std::runtime_error("Failed to open write-ahead log: " + path_);
+    }
+    flusher_ = std::thread(&writeAheadLog::flushLoop, this);
+}
+
+writeAheadLog::~writeAheadLog()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    flushCv_.notify_all();
+    if (flusher_.joinable())
+    {
+        flusher_.join();
+    }
+    closeLog();
+}
+
+uint64_t writeAheadLog::append(const std::string& record)
+{
+    uint64_t lsn;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lsn = nextLsn_++;
+        pending_ += frame(lsn, record);
+    }
+    flushCv_.notify_one();
+    return lsn;
+}
+
+bool writeAheadLog::waitDurable(uint64_t lsn)
+{
+    if (policy_ != syncPolicy::always)
+    {
+        return true;  // The flusher writes promptly; durability is traded for latency
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    durableCv_.wait(lock, [this, lsn] { return durableLsn_ >= lsn || stopping_; });
+    return !failed_;
+}
+
+uint64_t writeAheadLog::lastLsn() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return nextLsn_ - 1;
+}
+
+bool writeAheadLog::checkpoint(uint64_t coveredLsn, const std::string& record)
+{
+    // Let the flusher hand everything appended so far to the file before it is rewritten
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        uint64_t target = nextLsn_ - 1;
+        flushCv_.notify_one();
+        durableCv_.wait(lock, [this, target] { return durableLsn_ >= target || stopping_; });
+    }
+
+    std::lock_guard<std::mutex> fileLock(fileMutex_);
+    std::vector<std::pair<uint64_t, std::string>> records;
+    readLog(path_, records);
+
+    std::string contents = frame(coveredLsn, record);
+    for (const auto& entry : records)
+    {
+        if (entry.first > coveredLsn)
+        {
+            contents += frame(entry.first, entry.second);
+        }
+    }
+
+    // Write and sync the replacement before renaming it over the live log
+    std::string tmpPath = path_ + ".tmp";
+    closeLog();
+    bool written = openLog(tmpPath, true) && writeAll(contents) && syncLog();
+    closeLog();
+#ifdef _WIN32
+    std::remove(path_.c_str());  // rename does not replace existing files on Windows
+#endif
+    bool renamed = written && std::rename(tmpPath.c_str(), path_.c_str()) == 0 && syncDirectory(path_);
+    return openLog(path_, false) && renamed;
+}
+
+bool writeAheadLog::readLog(const std::string& path, std::vector<std::pair<uint64_t, std::string>>& outRecords)
+{
+    uint64_t validBytes = 0;
+    return readLog(path, outRecords, validBytes);
+}
+
+bool writeAheadLog::readLog(const std::string& path, std::vector<std::pair<uint64_t, std::string>>& outRecords,
+                            uint64_t& outValidBytes)
+{
+    outValidBytes = 0;
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        // A torn final line from a crash mid-write ends the log; every frame ends in a newline, so a last line
+        // without one is torn even when it happens to parse
+        nlohmann::json entry = nlohmann::json::parse(line, nullptr, false);
+        if (file.eof() || entry.is_discarded() || !entry.contains("lsn") || !entry.contains("record"))
+        {
+            break;
+        }
+        outRecords.emplace_back(entry["lsn"].get<uint64_t>(), entry["record"].dump());
+        outValidBytes += line.size() + 1;
+    }
+    return true;
+}
+
+bool writeAheadLog::truncateTail(const std::string& path, uint64_t validBytes, bool& outTruncated)
+{
+    outTruncated = false;
+#ifdef _WIN32
+    int fd = _open(path.c_str(), _O_RDWR | _O_BINARY);
+    if (fd < 0)
+    {
+        return true;  // No log yet
+    }
+    bool ok = true;
+    if (static_cast<uint64_t>(_lseeki64(fd, 0, SEEK_END)) > validBytes)
+    {
+        ok = _chsize_s(fd, static_cast<__int64>(validBytes)) == 0 && _commit(fd) == 0;
+        outTruncated = true;
+    }
+    return _close(fd) == 0 && ok;
+#else
+    int fd = open(path.c_str(), O_RDWR);
+    if (fd < 0)
+    {
+        return errno == ENOENT;  // No log yet
+    }
+    bool ok = true;
+    if (static_cast<uint64_t>(lseek(fd, 0, SEEK_END)) > validBytes)
+    {
+        ok = ftruncate(fd, static_cast<off_t>(validBytes)) == 0 && fsync(fd) == 0;
+        outTruncated = true;
+    }
+    return close(fd) == 0 && ok;
+#endif
+}
+
+bool writeAheadLog::parsePolicy(const std::string& name, syncPolicy& outPolicy)
+{
+    if (name == "always")
+    {
+        outPolicy = syncPolicy::always;
+    }
+    else if (name == "interval")
+    {
+        outPolicy = syncPolicy::interval;
+    }
+    else if (name == "none")
+    {
+        outPolicy = syncPolicy::none;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+void writeAheadLog::flushLoop()
+{
+    auto lastSync = std::chrono::steady_clock::now();
+    bool unsynced = false;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        auto hasWork = [this] { return stopping_ || !pending_.empty(); };
+        if (unsynced)
+        {
+            flushCv_.wait_until(lock, lastSync + syncInterval_, hasWork);
+        }
+        else
+        {
+            flushCv_.wait(lock, hasWork);
+        }
+
+        // Everything appended while the previous batch was being written shares this write and fsync
+        std::string batch;
+        batch.swap(pending_);
+        uint64_t batchLsn = nextLsn_ - 1;
+        bool stopping = stopping_;
+        lock.unlock();
+
+        bool ok = true;
+        {
+            std::lock_guard<std::mutex> fileLock(fileMutex_);
+            if (!batch.empty())
+            {
+                ok = writeAll(batch);
+                unsynced = true;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            bool dueSync = policy_ == syncPolicy::always ||
+                           (policy_ == syncPolicy::interval && (now - lastSync >= syncInterval_ || stopping));
+            if (unsynced && dueSync)
+            {
+                ok = syncLog() && ok;
+                lastSync = now;
+                unsynced = false;
+            }
+            else if (policy_ == syncPolicy::none)
+            {
+                unsynced = false;
+            }
+        }
+        if (!ok)
+        {
+            logger::error("wal", "Failed to write to write-ahead log", {{"path", path_}});
+        }
+
+        lock.lock();
+        failed_ = failed_ || !ok;
+        durableLsn_ = batchLsn;
+        durableCv_.notify_all();
+        if (stopping && pending_.empty())
+        {
+            return;
+        }
+    }
+}
+
+bool writeAheadLog::syncDirectory(const std::string& path)
+{
+#ifdef _WIN32
+    return true;  // Directories cannot be opened for flushing; NTFS journals the rename itself
+#else
+    std::string::size_type slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : path.substr(0, slash == 0 ? 1 : slash);
+    int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+#endif
+}
+
+bool writeAheadLog::openLog(const std::string& path, bool truncate)
+{
+#ifdef _WIN32
+    int flags = _O_WRONLY | _O_CREAT | _O_BINARY | (truncate ? _O_TRUNC : _O_APPEND);
+    fd_ = _open(path.c_str(), flags, _S_IREAD | _S_IWRITE);
+#else
+    int flags = O_WRONLY | O_CREAT | (truncate ? O_TRUNC : O_APPEND);
+    fd_ = open(path.c_str(), flags, 0644);
+#endif
+    return fd_ >= 0;
+}
+
+void writeAheadLog::closeLog()
+{
+    if (fd_ >= 0)
+    {
+#ifdef _WIN32
+        _close(fd_);
+#else
+        close(fd_);
+#endif
+        fd_ = -1;
+    }
+}
+
+bool writeAheadLog::writeAll(const std::string& data)
+{
+    size_t offset = 0;
+    while (offset < data.size())
+    {
+#ifdef _WIN32
+        int written = _write(fd_, data.data() + offset, static_cast<unsigned int>(data.size() - offset));
+#else
+        ssize_t written = write(fd_, data.data() + offset, data.size() - offset);
+#endif
+        if (written <= 0)
+        {
+            return false;
+        }
+        offset += static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool writeAheadLog::syncLog()
+{
+#ifdef _WIN32
+    return _commit(fd_) == 0;
+#else
+    return fsync(fd_) == 0;
+#endif
+}
+
+std::string writeAheadLog::frame(uint64_t lsn, const std::string& record)
+{
+    return "{\"lsn\":" + std::to_string(lsn) + ",\"record\":" + record + "}\n";
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Append-only mutation log with group commit - concurrent writers share each write and fsync
+class writeAheadLog
+{
+  public:
+    // always: committers wait for fsync; interval: fsync in the background; none: leave it to the OS
+    enum class syncPolicy
+    {
+        always,
+        interval,
+        none
+    };
+
+    writeAheadLog(const std::string& path, syncPolicy policy, uint64_t nextLsn,
+                  std::chrono::milliseconds syncInterval = std::chrono::milliseconds(100));
+    ~writeAheadLog();
+
+    // Records are serialized JSON objects; append only buffers, waitDurable applies the sync policy
+    uint64_t append(const std::string& record);
+    bool waitDurable(uint64_t lsn);
+    uint64_t lastLsn() const;
+
+    // Drop records covered by a saved project and start the log with the given checkpoint record
+    bool checkpoint(uint64_t coveredLsn, const std::string& record);
+
+    static bool readLog(const std::string& path, std::vector<std::pair<uint64_t, std::string>>& outRecords);
+    // outValidBytes is where the last complete record ends; anything after it is a torn write
+    static bool readLog(const std::string& path, std::vector<std::pair<uint64_t, std::string>>& outRecords,
+                        uint64_t& outValidBytes);
+    // Cuts a torn tail off so the next append starts on a fresh line; call before opening the log
+    static bool truncateTail(const std::string& path, uint64_t validBytes, bool& outTruncated);
+    static bool parsePolicy(const std::string& name, syncPolicy& outPolicy);
+
+    // Makes a rename into, or a file newly created in, the directory holding path survive a power loss
+    static bool syncDirectory(const std::string& path);
+
+  private:
+    std::string path_;
+    syncPolicy policy_;
+    std::chrono::milliseconds syncInterval_;
+    int fd_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable flushCv_;    // Wakes the flusher when records are pending
+    std::condition_variable durableCv_;  // Wakes committers when their batch is on disk
+    std::string pending_;                // Next group commit batch
+    uint64_t nextLsn_;
+    uint64_t durableLsn_;
+    bool failed_;
+    bool stopping_;
+
+    std::mutex fileMutex_;  // Serializes batch writes against checkpoint rewrites
+    std::thread flusher_;
+
+    void flushLoop();
+    bool openLog(const std::string& path, bool truncate);
+    void closeLog();
+    bool writeAll(const std::string& data);
+    bool syncLog();
+    static std::string frame(uint64_t lsn, const std::string& record);
+};
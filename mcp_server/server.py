@@ -186,7 +186,7 @@ async def execute_software_command(command: str, params: str = "{}") -> str:
     Execute a software-specific command.
 
     Args:
-        command: The command to execute (render, clear_scene, reset_camera, etc.)
+        command: The command to execute (render, render_all_cameras, clear_scene, reset_camera, etc.)
         params: JSON string containing additional command parameters
     """
     if not current_strategy: